@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "kdarklightmanager.h"
+#include "knighttimeclock_p.h"
+
+using namespace std::chrono_literals;
+
+/*
+ * The mock logind service lives in the test process, the sleep monitor is told to look for it on
+ * the session bus.
+ */
+static void prepareForSleep(bool sleep)
+{
+    auto signal = QDBusMessage::createSignal(QStringLiteral("/org/freedesktop/login1"), QStringLiteral("org.freedesktop.login1.Manager"), QStringLiteral("PrepareForSleep"));
+    signal.setArguments({sleep});
+    QDBusConnection::sessionBus().send(signal);
+}
+
+class ClockSkewTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void skewDuringSleep();
+    void skewWhileAwake();
+
+private:
+    QTemporaryDir m_homeDir;
+};
+
+void ClockSkewTest::initTestCase()
+{
+    QVERIFY(m_homeDir.isValid());
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(m_homeDir.filePath(QStringLiteral("config"))));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(m_homeDir.filePath(QStringLiteral("cache"))));
+    qputenv("XDG_STATE_HOME", QFile::encodeName(m_homeDir.filePath(QStringLiteral("state"))));
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(m_homeDir.path()));
+    qputenv("KNIGHTTIMED_LOGIND_BUS", "session");
+
+    QVERIFY(QDBusConnection::sessionBus().registerService(QStringLiteral("org.freedesktop.login1")));
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Times"));
+    config->sync();
+}
+
+void ClockSkewTest::skewDuringSleep()
+{
+    KNightTimeVirtualClock clock(QDateTime(QDate(2025, 1, 1), QTime(12, 0)));
+    KDarkLightManager manager(&clock);
+    manager.reconfigure();
+
+    const KDarkLightMetrics *metrics = manager.metrics();
+    const quint64 reschedules = metrics->reschedule.count();
+
+    prepareForSleep(true);
+    QTRY_COMPARE(metrics->sleeps, quint64(1));
+
+    // The clock jumps while the system is going to sleep, the schedule is computed only once it
+    // has resumed.
+    clock.skew(3h);
+    QCOMPARE(metrics->reschedule.count(), reschedules);
+
+    prepareForSleep(false);
+    QTRY_COMPARE(metrics->resume.count(), quint64(1));
+    QCOMPARE(metrics->reschedule.count(), reschedules + 1);
+    QVERIFY(manager.schedule().cycles().first().morning().startDateTime() <= clock.currentDateTime());
+}
+
+void ClockSkewTest::skewWhileAwake()
+{
+    KNightTimeVirtualClock clock(QDateTime(QDate(2025, 1, 1), QTime(12, 0)));
+    KDarkLightManager manager(&clock);
+    manager.reconfigure();
+
+    const KDarkLightMetrics *metrics = manager.metrics();
+    const quint64 reschedules = metrics->reschedule.count();
+
+    // A skew while the system is awake is handled right away.
+    clock.skew(-3h);
+    QCOMPARE(metrics->reschedule.count(), reschedules + 1);
+    QVERIFY(manager.schedule().cycles().first().morning().startDateTime() <= clock.currentDateTime());
+}
+
+QTEST_GUILESS_MAIN(ClockSkewTest)
+
+#include "clockskew_test.moc"
@@ -0,0 +1,167 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QObject>
+#include <QTest>
+#include <QTimeZone>
+
+#include "kdarklightschedule.h"
+#include "knighttimecoreconversions_p.h"
+
+using namespace std::chrono_literals;
+using namespace KNightTimeCore;
+
+static bool isSameTransition(const std::optional<KNightTimeCore::Transition> &transition, const std::optional<KDarkLightTransition> &expected)
+{
+    if (!transition || !expected) {
+        return !transition && !expected;
+    }
+    return int(transition->type) == int(expected->type()) //
+        && fromCoreTime(transition->start) == expected->startDateTime() //
+        && fromCoreTime(transition->end) == expected->endDateTime();
+}
+
+class CoreTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void relation();
+    void progress();
+    void timedForecast();
+    void solarForecast();
+    void lookup();
+    void state();
+    void stateCompatibility();
+};
+
+void CoreTest::relation()
+{
+    const KNightTimeCore::Transition transition{
+        .type = KNightTimeCore::Transition::Morning,
+        .start = toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 0))),
+        .end = toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 30))),
+    };
+
+    QCOMPARE(transition.test(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(5, 0)))), KNightTimeCore::Transition::Upcoming);
+    QCOMPARE(transition.test(toCoreTime(QDateTime(QDate(2025, 5, 26), QTime(5, 0)))), KNightTimeCore::Transition::Passed);
+
+    QCOMPARE(transition.test(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 0)))), KNightTimeCore::Transition::InProgress);
+    QCOMPARE(transition.test(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 15)))), KNightTimeCore::Transition::InProgress);
+    QCOMPARE(transition.test(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 30)))), KNightTimeCore::Transition::Passed);
+
+    QCOMPARE(transition.test(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(7, 0)))), KNightTimeCore::Transition::Passed);
+}
+
+void CoreTest::progress()
+{
+    const KNightTimeCore::Transition transition{
+        .type = KNightTimeCore::Transition::Morning,
+        .start = toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 0))),
+        .end = toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 30))),
+    };
+
+    QCOMPARE(transition.progress(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(5, 0)))), 0.0);
+    QCOMPARE(transition.progress(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 0)))), 0.0);
+    QCOMPARE(transition.progress(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 15)))), 0.5);
+    QCOMPARE(transition.progress(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(6, 30)))), 1.0);
+    QCOMPARE(transition.progress(toCoreTime(QDateTime(QDate(2025, 5, 25), QTime(7, 0)))), 1.0);
+}
+
+void CoreTest::timedForecast()
+{
+    // The core and the Qt forecasts must agree to the millisecond, including across the DST changes.
+    for (int month = 1; month <= 12; ++month) {
+        const QDateTime dateTime(QDate(2025, month, 15), QTime(12, 0));
+        QCOMPARE(KNightTimeCore::forecast(toCoreTime(dateTime)), toCoreSchedule(KDarkLightSchedule::forecast(dateTime)));
+        QCOMPARE(KNightTimeCore::forecast(toCoreTime(dateTime), 18h, 6h, 20min, 3),
+                 toCoreSchedule(KDarkLightSchedule::forecast(dateTime, QTime(18, 0), QTime(6, 0), 20min, 3)));
+    }
+}
+
+void CoreTest::solarForecast()
+{
+    const QTimeZone tz = QTimeZone::fromDurationAheadOfUtc(3h);
+    const QDateTime dateTime(QDate(2025, 5, 25), QTime(12, 0), tz);
+
+    QCOMPARE(KNightTimeCore::forecast(toCoreTime(dateTime), 90, 0), std::nullopt);
+    QCOMPARE(KNightTimeCore::forecast(toCoreTime(dateTime), -90, 0), std::nullopt);
+
+    // The Qt forecast is an adapter over the core one, so both must agree exactly.
+    const auto schedule = KNightTimeCore::forecast(toCoreTime(dateTime), 50.45, 30.52, 3);
+    QVERIFY(schedule);
+
+    const auto expected = KDarkLightSchedule::forecast(dateTime, 50.45, 30.52, 3);
+    QVERIFY(expected);
+    QCOMPARE(*schedule, toCoreSchedule(*expected));
+}
+
+void CoreTest::lookup()
+{
+    const KDarkLightSchedule schedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 3, 29), QTime(12, 0)), QTime(5, 45), QTime(19, 15), 40min, 2);
+    const KNightTimeCore::Schedule coreSchedule = toCoreSchedule(schedule);
+
+    // The lookups inside of the schedule as well as the extrapolated ones must match.
+    for (int day = -3; day < 6; ++day) {
+        for (int minute = 0; minute < 24 * 60; minute += 20) {
+            const QDateTime referenceDateTime(QDate(2025, 3, 29).addDays(day), QTime(0, 0).addSecs(minute * 60));
+            QVERIFY(isSameTransition(coreSchedule.previousTransition(toCoreTime(referenceDateTime)), schedule.previousTransition(referenceDateTime)));
+            QVERIFY(isSameTransition(coreSchedule.nextTransition(toCoreTime(referenceDateTime)), schedule.nextTransition(referenceDateTime)));
+        }
+    }
+
+    QCOMPARE(KNightTimeCore::Schedule().previousTransition(toCoreTime(QDateTime::currentDateTime())), std::nullopt);
+    QCOMPARE(KNightTimeCore::Schedule().nextTransition(toCoreTime(QDateTime::currentDateTime())), std::nullopt);
+}
+
+void CoreTest::state()
+{
+    QCOMPARE(KNightTimeCore::fromState(""), std::nullopt);
+    QCOMPARE(KNightTimeCore::fromState("foobar"), std::nullopt);
+    QCOMPARE(KNightTimeCore::toState(KNightTimeCore::Schedule()), std::string());
+
+    const auto schedule = KNightTimeCore::forecast(toCoreTime(QDateTime::currentDateTime()));
+    QCOMPARE(KNightTimeCore::fromState(KNightTimeCore::toState(schedule)), schedule);
+
+    // A truncated state is rejected rather than padded with zeroes.
+    const std::string state = KNightTimeCore::toState(schedule);
+    QCOMPARE(KNightTimeCore::fromState(std::string_view(state).substr(0, state.size() / 2)), std::nullopt);
+}
+
+void CoreTest::stateCompatibility()
+{
+    // This is what QDataStream produces for a cycle at 1000ms with transitions at 2-3ms and 4-5ms.
+    const std::string reference = "AAAAAQAAAAEAAAAAAAAD6AAAAAAAAAAAAAAAAgAAAAAAAAADAAAAAQAAAAAAAAAEAAAAAAAAAAU=";
+    const KNightTimeCore::Schedule referenceSchedule{
+        .cycles = {
+            KNightTimeCore::Cycle{
+                .noon = KNightTimeCore::TimePoint(1000ms),
+                .morning = KNightTimeCore::Transition{
+                    .type = KNightTimeCore::Transition::Morning,
+                    .start = KNightTimeCore::TimePoint(2ms),
+                    .end = KNightTimeCore::TimePoint(3ms),
+                },
+                .evening = KNightTimeCore::Transition{
+                    .type = KNightTimeCore::Transition::Evening,
+                    .start = KNightTimeCore::TimePoint(4ms),
+                    .end = KNightTimeCore::TimePoint(5ms),
+                },
+            },
+        },
+    };
+    QCOMPARE(KNightTimeCore::toState(referenceSchedule), reference);
+    QCOMPARE(KNightTimeCore::fromState(reference), referenceSchedule);
+
+    // The state strings can be passed between the core and the Qt types.
+    const KDarkLightSchedule schedule = KDarkLightSchedule::forecast(QDateTime::currentDateTime());
+    QCOMPARE(KNightTimeCore::toState(toCoreSchedule(schedule)), schedule.toState().toStdString());
+    QCOMPARE(KNightTimeCore::fromState(schedule.toState().toStdString()), toCoreSchedule(schedule));
+    QCOMPARE(KDarkLightSchedule::fromState(QString::fromStdString(KNightTimeCore::toState(toCoreSchedule(schedule)))), schedule);
+}
+
+QTEST_MAIN(CoreTest)
+
+#include "core_test.moc"
@@ -0,0 +1,53 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "knighttimecore.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * A minimal consumer of the core library: it computes a solar schedule, looks up the next
+ * transition, round-trips the state, and reports its resident size.
+ */
+
+static long residentMemory()
+{
+    FILE *status = std::fopen("/proc/self/status", "r");
+    if (!status) {
+        return -1;
+    }
+
+    long kib = -1;
+    char line[256];
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, "VmRSS:", 6) == 0) {
+            kib = std::strtol(line + 6, nullptr, 10);
+            break;
+        }
+    }
+
+    std::fclose(status);
+    return kib;
+}
+
+int main()
+{
+    const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+
+    const auto schedule = KNightTimeCore::forecast(now, 50.45, 30.52);
+    if (!schedule || !schedule->nextTransition(now)) {
+        return 1;
+    }
+
+    if (KNightTimeCore::fromState(KNightTimeCore::toState(*schedule)) != schedule) {
+        return 1;
+    }
+
+    std::printf("%ld\n", residentMemory());
+    return 0;
+}
@@ -0,0 +1,196 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVariant>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+struct Transition
+{
+    uint type;
+    qint64 start;
+    qint64 end;
+};
+
+static QList<Transition> readTransitions(const QDBusArgument &argument)
+{
+    QList<Transition> transitions;
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        Transition transition;
+        argument.beginStructure();
+        argument >> transition.type >> transition.start >> transition.end;
+        argument.endStructure();
+        transitions.append(transition);
+    }
+    argument.endArray();
+    return transitions;
+}
+
+static QDBusMessage createMethodCall(const QString &method)
+{
+    return QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), method);
+}
+
+class DaemonApiTest : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void OnRefreshed(const QDBusMessage &message);
+    void OnRefreshedCycles(const QDBusMessage &message);
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void version();
+    void getTransitions();
+    void getTransitionsInvalidWindow();
+    void refreshedCycles();
+
+private:
+    DaemonProcess m_daemon;
+    QList<QDBusMessage> m_refreshed;
+    QList<QDBusMessage> m_refreshedCycles;
+};
+
+void DaemonApiTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The API test must be run on a private session bus");
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    // The fixed times make the transitions easy to predict.
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Times"));
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("RefreshCoalescingInterval"), 0);
+    config->sync();
+
+    QVERIFY(m_daemon.start());
+
+    auto bus = QDBusConnection::sessionBus();
+    bus.connect(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Refreshed"), this, SLOT(OnRefreshed(QDBusMessage)));
+    bus.connect(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("RefreshedCycles"), this, SLOT(OnRefreshedCycles(QDBusMessage)));
+}
+
+void DaemonApiTest::cleanupTestCase()
+{
+    m_daemon.stop();
+}
+
+void DaemonApiTest::OnRefreshed(const QDBusMessage &message)
+{
+    m_refreshed.append(message);
+}
+
+void DaemonApiTest::OnRefreshedCycles(const QDBusMessage &message)
+{
+    m_refreshedCycles.append(message);
+}
+
+void DaemonApiTest::version()
+{
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
+    message.setArguments({QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Version")});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    QCOMPARE(reply.arguments().constFirst().value<QDBusVariant>().variant().toUInt(), 3u);
+}
+
+void DaemonApiTest::getTransitions()
+{
+    const QDateTime from = QDateTime::currentDateTime();
+    const QDateTime to = from.addDays(1);
+
+    auto message = createMethodCall(QStringLiteral("GetTransitions"));
+    message.setArguments({from.toMSecsSinceEpoch(), to.toMSecsSinceEpoch()});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    QCOMPARE(reply.signature(), QStringLiteral("a(uxx)"));
+
+    // Depending on the current time, the window can catch the end of an ongoing transition as well.
+    const QList<Transition> transitions = readTransitions(reply.arguments().constFirst().value<QDBusArgument>());
+    QVERIFY(transitions.size() == 2 || transitions.size() == 3);
+
+    for (qsizetype i = 0; i < transitions.size(); ++i) {
+        const Transition &transition = transitions[i];
+        QVERIFY(transition.end > from.toMSecsSinceEpoch());
+        QVERIFY(transition.start < to.toMSecsSinceEpoch());
+        QCOMPARE(transition.end - transition.start, qint64(1800000));
+
+        const QTime startTime = QDateTime::fromMSecsSinceEpoch(transition.start).time();
+        QCOMPARE(startTime, transition.type == 0 ? QTime(6, 0) : QTime(18, 0));
+
+        if (i > 0) {
+            QCOMPARE(transition.type, 1 - transitions[i - 1].type);
+            QVERIFY(transitions[i - 1].end <= transition.start);
+        }
+    }
+}
+
+void DaemonApiTest::getTransitionsInvalidWindow()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    auto message = createMethodCall(QStringLiteral("GetTransitions"));
+    message.setArguments({now, now});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+    QCOMPARE(reply.errorName(), QStringLiteral("org.freedesktop.DBus.Error.InvalidArgs"));
+}
+
+void DaemonApiTest::refreshedCycles()
+{
+    auto message = createMethodCall(QStringLiteral("Subscribe"));
+    message.setArguments({QVariantMap{
+        {QStringLiteral("TypedRefreshed"), true},
+    }});
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("Times")).writeEntry(QStringLiteral("TransitionDuration"), 1200, KConfig::Notify);
+    config->sync();
+
+    QTRY_COMPARE(m_refreshedCycles.size(), 1);
+    QCOMPARE(m_refreshed.size(), 0);
+
+    const QDBusMessage signal = m_refreshedCycles.constFirst();
+    QCOMPARE(signal.signature(), QStringLiteral("a(xxxxx)"));
+
+    const QDBusArgument argument = signal.arguments().constFirst().value<QDBusArgument>();
+    int cycleCount = 0;
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        qint64 noon, morningStart, morningEnd, eveningStart, eveningEnd;
+        argument.beginStructure();
+        argument >> noon >> morningStart >> morningEnd >> eveningStart >> eveningEnd;
+        argument.endStructure();
+
+        QCOMPARE(morningEnd - morningStart, qint64(1200000));
+        QCOMPARE(eveningEnd - eveningStart, qint64(1200000));
+        ++cycleCount;
+    }
+    argument.endArray();
+    QVERIFY(cycleCount > 0);
+}
+
+QTEST_GUILESS_MAIN(DaemonApiTest)
+
+#include "daemon_apitest.moc"
@@ -0,0 +1,157 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QTest>
+#include <QThread>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+using namespace std::chrono_literals;
+
+/*
+ * The wakeups of a process are approximated by the number of times it has been scheduled out.
+ */
+static qint64 contextSwitches(qint64 pid)
+{
+    QFile status(QStringLiteral("/proc/%1/status").arg(pid));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    qint64 switches = 0;
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("voluntary_ctxt_switches:")) {
+            switches += line.mid(24).trimmed().toLongLong();
+        } else if (line.startsWith("nonvoluntary_ctxt_switches:")) {
+            switches += line.mid(27).trimmed().toLongLong();
+        }
+    }
+
+    return switches;
+}
+
+class DaemonIdleBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void idleDay_data();
+    void idleDay();
+
+private:
+    void setIdleTimeout(uint timeout);
+
+    DaemonProcess m_daemon;
+    // A whole day in real time is too long, the wakeups are extrapolated from a shorter window.
+    std::chrono::seconds m_window = 60s;
+};
+
+void DaemonIdleBenchmark::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The idle benchmark must be run on a private session bus");
+    }
+
+    if (const int window = qEnvironmentVariableIntValue("KNIGHTTIME_IDLEBENCHMARK_SECONDS")) {
+        m_window = std::chrono::seconds(window);
+    }
+
+    QVERIFY(m_daemon.isValid());
+}
+
+void DaemonIdleBenchmark::cleanupTestCase()
+{
+    m_daemon.stop();
+}
+
+void DaemonIdleBenchmark::setIdleTimeout(uint timeout)
+{
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("IdleTimeout"), timeout);
+    config->sync();
+}
+
+void DaemonIdleBenchmark::idleDay_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<bool>("automaticLocation");
+
+    QTest::addRow("times") << QStringLiteral("Times") << false;
+    QTest::addRow("automatic location") << QStringLiteral("Location") << true;
+}
+
+void DaemonIdleBenchmark::idleDay()
+{
+    QFETCH(QString, source);
+    QFETCH(bool, automaticLocation);
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), source);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Automatic"), automaticLocation);
+    config->sync();
+
+    // The replayed positions keep the position polling going without a positioning backend.
+    QProcessEnvironment environment;
+    if (automaticLocation) {
+        environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY"), QFINDTESTDATA("data/stationary.nmea"));
+    }
+
+    // Without the idle timeout, the daemon stays resident after its last subscriber is gone.
+    setIdleTimeout(0);
+    QVERIFY(m_daemon.start(environment));
+    {
+        DaemonClient client(QStringLiteral("idlebenchmark-client"));
+        QVERIFY(client.subscribe());
+        client.unsubscribe();
+    }
+    QTRY_COMPARE(m_daemon.subscriberCount(), 0u);
+    QTest::qWait(2000);
+
+    const qint64 switchesBefore = contextSwitches(m_daemon.processId());
+    QThread::sleep(m_window);
+    const qint64 switchesAfter = contextSwitches(m_daemon.processId());
+    const qint64 residentMemory = m_daemon.residentMemory();
+    m_daemon.stop();
+
+    const qint64 wakeupsPerDay = (switchesAfter - switchesBefore) * std::chrono::seconds(24h).count() / m_window.count();
+
+    // With the idle timeout, the daemon exits, and the next start answers from the saved state.
+    setIdleTimeout(1);
+    QVERIFY(m_daemon.start(environment));
+    {
+        DaemonClient client(QStringLiteral("idlebenchmark-client"));
+        QVERIFY(client.subscribe());
+        client.unsubscribe();
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(!m_daemon.isRunning(), 5000);
+
+    QVERIFY(m_daemon.start(environment));
+    DaemonClient client(QStringLiteral("idlebenchmark-client"));
+    QVERIFY(client.subscribe());
+    QVERIFY(client.results.contains(QStringLiteral("Schedule")));
+    client.unsubscribe();
+    QTRY_VERIFY_WITH_TIMEOUT(!m_daemon.isRunning(), 5000);
+
+    qInfo("%s: an idle resident daemon uses %lld KiB and wakes up about %lld times a day (extrapolated from %llds), "
+          "both are saved while it has exited; after an idle exit, the first Subscribe() was answered in %lldus",
+          QTest::currentDataTag(),
+          residentMemory / 1024,
+          wakeupsPerDay,
+          qint64(m_window.count()),
+          qint64(std::chrono::duration_cast<std::chrono::microseconds>(client.latency).count()));
+}
+
+QTEST_GUILESS_MAIN(DaemonIdleBenchmark)
+
+#include "daemon_idlebenchmark.moc"
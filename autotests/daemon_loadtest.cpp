@@ -0,0 +1,299 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QTest>
+
+#include "daemonprocess.h"
+#include "kdarklightschedulesubscription_p.h"
+#include "knighttimetrace_p.h"
+
+using namespace std::chrono_literals;
+
+class DaemonLoadTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void churn();
+    void refreshFanOut();
+    void restart();
+
+private:
+    std::vector<std::unique_ptr<DaemonClient>> createClients(int count);
+
+    DaemonProcess m_daemon;
+    QString m_traceFileName;
+    int m_clientCount = 500;
+    int m_lastClientId = 0;
+};
+
+static qint64 timestamp()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Returns the Subscribe() calls that KDarkLightScheduleSubscription has made after the given time. The
+ * trace is still open, but every event is on its own line.
+ */
+static QList<QJsonObject> readSubscribeCalls(const QString &fileName, qint64 since)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QList<QJsonObject> calls;
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (QByteArray line : lines) {
+        if (line.endsWith(',')) {
+            line.chop(1);
+        }
+        if (!line.startsWith('{')) {
+            continue;
+        }
+
+        const QJsonObject event = QJsonDocument::fromJson(line).object();
+        if (event.value(QStringLiteral("cat")).toString() == QLatin1String("subscription")
+            && event.value(QStringLiteral("name")).toString() == QLatin1String("Subscribe")
+            && event.value(QStringLiteral("ts")).toInteger() >= since) {
+            calls.append(event);
+        }
+    }
+
+    return calls;
+}
+
+static std::chrono::microseconds percentile(std::vector<std::chrono::nanoseconds> samples, qreal fraction)
+{
+    std::sort(samples.begin(), samples.end());
+    const size_t index = std::clamp<size_t>(std::ceil(fraction * samples.size()), 1, samples.size()) - 1;
+    return std::chrono::duration_cast<std::chrono::microseconds>(samples[index]);
+}
+
+void DaemonLoadTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The load test must be run on a private session bus");
+    }
+
+    if (const int clientCount = qEnvironmentVariableIntValue("KNIGHTTIME_LOADTEST_CLIENTS")) {
+        m_clientCount = clientCount;
+    }
+
+    // Only the schedule subscriptions in this process are traced, the daemon must not be slowed down.
+    if (qEnvironmentVariableIsSet("KNIGHTTIME_TRACE_FILE")) {
+        m_traceFileName = qEnvironmentVariable("KNIGHTTIME_TRACE_FILE").replace(QLatin1String("%p"), QString::number(QCoreApplication::applicationPid()));
+        qunsetenv("KNIGHTTIME_TRACE_FILE");
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    // Avoid the positioning backend, the load test is only concerned with the D-Bus interface.
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Times"));
+    // Measure the fan-out itself rather than the coalescing window.
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("RefreshCoalescingInterval"), 0);
+    config->sync();
+
+    QVERIFY(m_daemon.start());
+}
+
+void DaemonLoadTest::cleanupTestCase()
+{
+    m_daemon.stop();
+}
+
+std::vector<std::unique_ptr<DaemonClient>> DaemonLoadTest::createClients(int count)
+{
+    std::vector<std::unique_ptr<DaemonClient>> clients;
+    clients.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        clients.push_back(std::make_unique<DaemonClient>(QStringLiteral("loadtest-client-%1").arg(m_lastClientId++)));
+    }
+    return clients;
+}
+
+void DaemonLoadTest::churn()
+{
+    const qint64 initialMemory = m_daemon.residentMemory();
+
+    // Every round, a quarter of the clients unsubscribes properly, another quarter subscribes twice
+    // and then crashes, and the rest crash with a single subscription.
+    const int roundCount = 4;
+    for (int round = 0; round < roundCount; ++round) {
+        auto clients = createClients(m_clientCount);
+
+        std::vector<std::chrono::nanoseconds> latencies;
+        latencies.reserve(m_clientCount * 2);
+        for (int i = 0; i < m_clientCount; ++i) {
+            QVERIFY(clients[i]->isConnected());
+
+            QVERIFY(clients[i]->subscribe());
+            latencies.push_back(clients[i]->latency);
+
+            if (i % 4 == 1) {
+                QVERIFY(clients[i]->subscribe());
+                latencies.push_back(clients[i]->latency);
+            }
+        }
+
+        QCOMPARE(m_daemon.subscriberCount(), uint(m_clientCount + m_clientCount / 4));
+
+        qInfo("round %d: Subscribe latency p50 = %lldus, p90 = %lldus, p99 = %lldus, max = %lldus", round,
+              qint64(percentile(latencies, 0.5).count()),
+              qint64(percentile(latencies, 0.9).count()),
+              qint64(percentile(latencies, 0.99).count()),
+              qint64(percentile(latencies, 1.0).count()));
+
+        for (int i = 0; i < m_clientCount; i += 4) {
+            clients[i]->unsubscribe();
+        }
+
+        clients.clear();
+        QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+        QCOMPARE(m_daemon.metrics().value(QStringLiteral("SubscribedServices")).toUInt(), 0u);
+    }
+
+    const qint64 finalMemory = m_daemon.residentMemory();
+    qInfo("daemon resident memory: %lld KiB before, %lld KiB after %d rounds", initialMemory / 1024, finalMemory / 1024, roundCount);
+}
+
+void DaemonLoadTest::refreshFanOut()
+{
+    auto clients = createClients(m_clientCount);
+    for (const auto &client : clients) {
+        QVERIFY(client->subscribe());
+    }
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    auto group = config->group(QStringLiteral("Times"));
+    const int transitionDuration = group.readEntry(QStringLiteral("TransitionDuration"), 1800);
+    group.writeEntry(QStringLiteral("TransitionDuration"), transitionDuration == 1800 ? 1200 : 1800, KConfig::Notify);
+
+    const auto changeTime = std::chrono::steady_clock::now();
+    config->sync();
+
+    QTRY_VERIFY_WITH_TIMEOUT(std::ranges::all_of(clients, [](const auto &client) {
+        return client->refreshCount > 0;
+    }),
+                             10000);
+
+    for (const auto &client : clients) {
+        QCOMPARE(client->refreshCount, 1);
+    }
+
+    const auto lastRefreshTime = (*std::ranges::max_element(clients, {}, &DaemonClient::lastRefreshTime))->lastRefreshTime;
+    qInfo("Refreshed fan-out to %d clients took %lldus", m_clientCount, qint64(std::chrono::duration_cast<std::chrono::microseconds>(lastRefreshTime - changeTime).count()));
+
+    clients.clear();
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+}
+
+void DaemonLoadTest::restart()
+{
+    if (m_traceFileName.isEmpty()) {
+        QSKIP("The restart test needs KNIGHTTIME_TRACE_FILE to measure the Subscribe() calls, run it with ctest");
+    }
+
+    // The baseline: all the clients subscribe at the same moment after the daemon has been restarted.
+    std::vector<std::chrono::nanoseconds> burstLatencies;
+    {
+        auto clients = createClients(m_clientCount);
+
+        m_daemon.stop();
+        QVERIFY(m_daemon.start());
+        for (const auto &client : clients) {
+            client->asyncSubscribe();
+        }
+
+        QTRY_VERIFY_WITH_TIMEOUT(std::ranges::all_of(clients, [](const auto &client) {
+            return client->replied;
+        }),
+                                 20000);
+
+        burstLatencies.reserve(clients.size());
+        for (const auto &client : clients) {
+            QVERIFY(client->results.contains(QStringLiteral("Cookie")));
+            burstLatencies.push_back(client->latency);
+        }
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+
+    // The schedule subscriptions notice the new daemon at the same moment too, but they spread their
+    // Subscribe() calls over a short window.
+    std::vector<std::unique_ptr<KDarkLightScheduleSubscription>> subscriptions;
+    subscriptions.reserve(m_clientCount);
+    for (int i = 0; i < m_clientCount; ++i) {
+        subscriptions.push_back(std::make_unique<KDarkLightScheduleSubscription>());
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), uint(m_clientCount), 20000);
+
+    const quint64 batchesBefore = m_daemon.metrics().value(QStringLiteral("SubscribeBatches")).toULongLong();
+
+    m_daemon.stop();
+    const qint64 restartTimestamp = timestamp();
+    QVERIFY(m_daemon.start());
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), uint(m_clientCount), 20000);
+
+    const quint64 batches = m_daemon.metrics().value(QStringLiteral("SubscribeBatches")).toULongLong() - batchesBefore;
+
+    KNightTimeTracer::self()->flush();
+    const QList<QJsonObject> calls = readSubscribeCalls(m_traceFileName, restartTimestamp);
+    QCOMPARE(calls.size(), qsizetype(m_clientCount));
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(calls.size());
+    qint64 firstCallTimestamp = std::numeric_limits<qint64>::max();
+    qint64 lastCallTimestamp = std::numeric_limits<qint64>::min();
+    for (const QJsonObject &call : calls) {
+        const qint64 callTimestamp = call.value(QStringLiteral("ts")).toInteger();
+        firstCallTimestamp = std::min(firstCallTimestamp, callTimestamp);
+        lastCallTimestamp = std::max(lastCallTimestamp, callTimestamp);
+        latencies.push_back(std::chrono::microseconds(call.value(QStringLiteral("dur")).toInteger()));
+    }
+    const std::chrono::milliseconds spread = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::microseconds(lastCallTimestamp - firstCallTimestamp));
+
+    qInfo("burst: Subscribe latency after a restart p50 = %lldus, p90 = %lldus, p99 = %lldus, max = %lldus",
+          qint64(percentile(burstLatencies, 0.5).count()),
+          qint64(percentile(burstLatencies, 0.9).count()),
+          qint64(percentile(burstLatencies, 0.99).count()),
+          qint64(percentile(burstLatencies, 1.0).count()));
+    qInfo("subscriptions: Subscribe latency after a restart p50 = %lldus, p90 = %lldus, p99 = %lldus, max = %lldus, calls spread over %lldms, answered in %llu batches",
+          qint64(percentile(latencies, 0.5).count()),
+          qint64(percentile(latencies, 0.9).count()),
+          qint64(percentile(latencies, 0.99).count()),
+          qint64(percentile(latencies, 1.0).count()),
+          qint64(spread.count()),
+          batches);
+
+    // The subscriptions delay their calls by up to 500ms. With a handful of them, the window can
+    // come out narrow by chance.
+    if (m_clientCount >= 10) {
+        QVERIFY(spread >= 125ms);
+    }
+
+    // Spreading the calls must not make the slowest one worse than when they all arrive at once.
+    QVERIFY(percentile(latencies, 1.0) <= std::max<std::chrono::microseconds>(percentile(burstLatencies, 1.0), 50ms));
+    QVERIFY(batches <= quint64(m_clientCount));
+
+    subscriptions.clear();
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+}
+
+QTEST_GUILESS_MAIN(DaemonLoadTest)
+
+#include "daemon_loadtest.moc"
@@ -0,0 +1,147 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+#include <algorithm>
+
+class DaemonLoginStormTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void storm();
+    void singleChange();
+
+private:
+    void reconfigure(const QString &key, const QVariant &value);
+
+    DaemonProcess m_daemon;
+    std::vector<std::unique_ptr<DaemonClient>> m_clients;
+};
+
+static quint64 histogramCount(const QVariantMap &metrics, const QString &name)
+{
+    return qdbus_cast<QVariantMap>(metrics.value(name)).value(QStringLiteral("Count")).toULongLong();
+}
+
+static quint64 counter(const QVariantMap &metrics, const QString &name)
+{
+    return metrics.value(name).toULongLong();
+}
+
+void DaemonLoginStormTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The login storm test must be run on a private session bus");
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    // Use a manual location, so every schedule change is triggered by the test. The coalescing
+    // window is wider than usual, so a slow machine can still fit the whole storm in it.
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("RefreshCoalescingInterval"), 2000);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Location"));
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Automatic"), false);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Latitude"), 50.45);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Longitude"), 30.52);
+    config->sync();
+
+    QVERIFY(m_daemon.start());
+
+    // Applications that are started at login subscribe all at once.
+    for (int i = 0; i < 16; ++i) {
+        auto client = std::make_unique<DaemonClient>(QStringLiteral("loginstorm-client-%1").arg(i));
+        QVERIFY(client->subscribe());
+        m_clients.push_back(std::move(client));
+    }
+}
+
+void DaemonLoginStormTest::cleanupTestCase()
+{
+    m_clients.clear();
+    m_daemon.stop();
+}
+
+void DaemonLoginStormTest::reconfigure(const QString &key, const QVariant &value)
+{
+    const quint64 before = histogramCount(m_daemon.metrics(), QStringLiteral("Reconfigure"));
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("Location")).writeEntry(key, value, KConfig::Notify);
+    config->sync();
+
+    QTRY_VERIFY(histogramCount(m_daemon.metrics(), QStringLiteral("Reconfigure")) > before);
+}
+
+void DaemonLoginStormTest::storm()
+{
+    const QVariantMap before = m_daemon.metrics();
+
+    // The config is reloaded and the location gets refined several times in a row.
+    reconfigure(QStringLiteral("Longitude"), 20.0);
+    reconfigure(QStringLiteral("Longitude"), 10.0);
+    reconfigure(QStringLiteral("Latitude"), 40.0);
+    reconfigure(QStringLiteral("Longitude"), 0.0);
+
+    QTRY_VERIFY(std::ranges::all_of(m_clients, [](const auto &client) {
+        return client->refreshCount > 0;
+    }));
+
+    // Wait for the coalescing window to close, so any extra signals would have arrived.
+    QTest::qWait(3000);
+
+    const QVariantMap after = m_daemon.metrics();
+    const quint64 scheduleChanges = counter(after, QStringLiteral("ScheduleChanges")) - counter(before, QStringLiteral("ScheduleChanges"));
+    const quint64 coalescedRefreshes = counter(after, QStringLiteral("CoalescedRefreshes")) - counter(before, QStringLiteral("CoalescedRefreshes"));
+    const quint64 refreshedSignals = counter(after, QStringLiteral("RefreshedSignals")) - counter(before, QStringLiteral("RefreshedSignals"));
+    qInfo("%llu schedule changes, %llu coalesced, %llu Refreshed signals sent to %zu clients",
+          scheduleChanges,
+          coalescedRefreshes,
+          refreshedSignals,
+          m_clients.size());
+
+    QCOMPARE(scheduleChanges, quint64(4));
+    QCOMPARE(coalescedRefreshes, quint64(3));
+    QCOMPARE(refreshedSignals, quint64(m_clients.size()));
+    for (const auto &client : m_clients) {
+        QCOMPARE(client->refreshCount, 1);
+    }
+}
+
+void DaemonLoginStormTest::singleChange()
+{
+    for (const auto &client : m_clients) {
+        client->refreshCount = 0;
+    }
+
+    reconfigure(QStringLiteral("Longitude"), 30.52);
+
+    QTRY_VERIFY(std::ranges::all_of(m_clients, [](const auto &client) {
+        return client->refreshCount > 0;
+    }));
+
+    QTest::qWait(3000);
+    for (const auto &client : m_clients) {
+        QCOMPARE(client->refreshCount, 1);
+    }
+}
+
+QTEST_GUILESS_MAIN(DaemonLoginStormTest)
+
+#include "daemon_loginstormtest.moc"
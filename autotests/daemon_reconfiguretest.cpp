@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusArgument>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+class DaemonReconfigureTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void configWrite_data();
+    void configWrite();
+
+private:
+    DaemonProcess m_daemon;
+};
+
+static quint64 histogramCount(const QVariantMap &metrics, const QString &name)
+{
+    return qdbus_cast<QVariantMap>(metrics.value(name)).value(QStringLiteral("Count")).toULongLong();
+}
+
+void DaemonReconfigureTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The reconfigure test must be run on a private session bus");
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    // A device that stays at the same place, so position updates never cause forecasts on their own.
+    QProcessEnvironment environment;
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY"), QFINDTESTDATA("data/stationary.nmea"));
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY_SPEED"), QStringLiteral("0"));
+    QVERIFY(m_daemon.start(environment));
+
+    QTRY_COMPARE(m_daemon.metrics().value(QStringLiteral("PositionUpdatesReceived")).toULongLong(), quint64(1));
+}
+
+void DaemonReconfigureTest::cleanupTestCase()
+{
+    m_daemon.stop();
+}
+
+void DaemonReconfigureTest::configWrite_data()
+{
+    QTest::addColumn<QString>("group");
+    QTest::addColumn<QString>("key");
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<quint64>("positionSourceStarts");
+    QTest::addColumn<quint64>("forecasts");
+
+    // The rows are applied one after another, starting with the automatic location.
+    QTest::addRow("unrelated key") << QStringLiteral("General") << QStringLiteral("Unrelated") << QStringLiteral("1") << quint64(0) << quint64(0);
+    QTest::addRow("idle timeout") << QStringLiteral("General") << QStringLiteral("IdleTimeout") << QStringLiteral("0") << quint64(0) << quint64(0);
+    QTest::addRow("fallback times") << QStringLiteral("Times") << QStringLiteral("TransitionDuration") << QStringLiteral("1200") << quint64(0) << quint64(0);
+    QTest::addRow("manual latitude while automatic") << QStringLiteral("Location") << QStringLiteral("Latitude") << QStringLiteral("50.45") << quint64(0) << quint64(0);
+    QTest::addRow("manual location") << QStringLiteral("Location") << QStringLiteral("Automatic") << QStringLiteral("false") << quint64(0) << quint64(1);
+    QTest::addRow("manual longitude") << QStringLiteral("Location") << QStringLiteral("Longitude") << QStringLiteral("30.52") << quint64(0) << quint64(1);
+    QTest::addRow("times while manual") << QStringLiteral("Times") << QStringLiteral("SunriseStart") << QStringLiteral("07:00:00") << quint64(0) << quint64(0);
+    QTest::addRow("automatic location") << QStringLiteral("Location") << QStringLiteral("Automatic") << QStringLiteral("true") << quint64(1) << quint64(1);
+    QTest::addRow("same value") << QStringLiteral("Location") << QStringLiteral("Automatic") << QStringLiteral("1") << quint64(0) << quint64(0);
+    QTest::addRow("times") << QStringLiteral("General") << QStringLiteral("Source") << QStringLiteral("Times") << quint64(0) << quint64(1);
+    QTest::addRow("location") << QStringLiteral("General") << QStringLiteral("Source") << QStringLiteral("Location") << quint64(1) << quint64(1);
+    QTest::addRow("shared instance") << QStringLiteral("General") << QStringLiteral("SharedInstance") << QStringLiteral("true") << quint64(0) << quint64(1);
+    QTest::addRow("per-session instance") << QStringLiteral("General") << QStringLiteral("SharedInstance") << QStringLiteral("false") << quint64(0) << quint64(1);
+}
+
+void DaemonReconfigureTest::configWrite()
+{
+    QFETCH(QString, group);
+    QFETCH(QString, key);
+    QFETCH(QString, value);
+    QFETCH(quint64, positionSourceStarts);
+    QFETCH(quint64, forecasts);
+
+    const QVariantMap before = m_daemon.metrics();
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(group).writeEntry(key, value, KConfig::Notify);
+    config->sync();
+
+    QVariantMap after;
+    QTRY_VERIFY((after = m_daemon.metrics(), histogramCount(after, QStringLiteral("Reconfigure")) > histogramCount(before, QStringLiteral("Reconfigure"))));
+
+    const quint64 actualPositionSourceStarts = after.value(QStringLiteral("PositionSourceStarts")).toULongLong() - before.value(QStringLiteral("PositionSourceStarts")).toULongLong();
+    const quint64 actualForecasts = histogramCount(after, QStringLiteral("Reschedule")) - histogramCount(before, QStringLiteral("Reschedule"));
+    qInfo("%s: %llu position source restarts, %llu forecasts", QTest::currentDataTag(), actualPositionSourceStarts, actualForecasts);
+
+    QCOMPARE(actualPositionSourceStarts, positionSourceStarts);
+    QCOMPARE(actualForecasts, forecasts);
+}
+
+QTEST_GUILESS_MAIN(DaemonReconfigureTest)
+
+#include "daemon_reconfiguretest.moc"
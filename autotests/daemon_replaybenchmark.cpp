@@ -0,0 +1,70 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusArgument>
+#include <QObject>
+#include <QTest>
+
+#include "daemonprocess.h"
+
+class DaemonReplayBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void replay_data();
+    void replay();
+};
+
+void DaemonReplayBenchmark::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The replay benchmark must be run on a private session bus");
+    }
+}
+
+void DaemonReplayBenchmark::replay_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<qulonglong>("positionCount");
+
+    QTest::addRow("commute") << QFINDTESTDATA("data/commute.nmea") << qulonglong(721);
+    QTest::addRow("flight") << QFINDTESTDATA("data/flight.nmea") << qulonglong(1021);
+}
+
+void DaemonReplayBenchmark::replay()
+{
+    QFETCH(QString, fileName);
+    QFETCH(qulonglong, positionCount);
+
+    DaemonProcess daemon;
+    QVERIFY(daemon.isValid());
+
+    QProcessEnvironment environment;
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY"), fileName);
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY_SPEED"), QStringLiteral("0"));
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_UPDATES"), QStringLiteral("continuous"));
+    QVERIFY(daemon.start(environment));
+
+    QVariantMap metrics;
+    QTRY_VERIFY_WITH_TIMEOUT((metrics = daemon.metrics()).value(QStringLiteral("PositionUpdatesReceived")).toULongLong() == positionCount, 30000);
+
+    const QVariantMap reschedule = qdbus_cast<QVariantMap>(metrics.value(QStringLiteral("Reschedule")));
+    qInfo("%s: %llu position updates, %llu ignored, %llu reschedules (forecasts) taking %llu us in total, %llu schedule changes (Refreshed fan-outs)",
+          QTest::currentDataTag(),
+          metrics.value(QStringLiteral("PositionUpdatesReceived")).toULongLong(),
+          metrics.value(QStringLiteral("PositionUpdatesIgnored")).toULongLong(),
+          reschedule.value(QStringLiteral("Count")).toULongLong(),
+          reschedule.value(QStringLiteral("TotalUsec")).toULongLong(),
+          metrics.value(QStringLiteral("ScheduleChanges")).toULongLong());
+
+    daemon.stop();
+}
+
+QTEST_GUILESS_MAIN(DaemonReplayBenchmark)
+
+#include "daemon_replaybenchmark.moc"
@@ -0,0 +1,260 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusVariant>
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+#include <csignal>
+#include <unistd.h>
+
+/*
+ * Every simulated session runs knighttimed on its own private session bus. A separate bus daemon
+ * plays the role of the system bus, it is shared by all sessions and the system instance.
+ */
+
+static QByteArray readProcFile(qint64 pid, const char *fileName)
+{
+    QFile file(QStringLiteral("/proc/%1/%2").arg(pid).arg(QLatin1String(fileName)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+static qint64 findChildProcess(qint64 pid, const QByteArray &name)
+{
+    const QList<QByteArray> children = readProcFile(pid, QByteArray("task/" + QByteArray::number(pid) + "/children").constData()).split(' ');
+    for (const QByteArray &child : children) {
+        const qint64 childPid = child.toLongLong();
+        if (childPid && readProcFile(childPid, "comm").trimmed() == name) {
+            return childPid;
+        }
+    }
+    return 0;
+}
+
+static qint64 residentMemory(qint64 pid)
+{
+    const QList<QByteArray> lines = readProcFile(pid, "status").split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').constFirst().toLongLong();
+        }
+    }
+    return 0;
+}
+
+static qint64 cpuTime(qint64 pid)
+{
+    // The utime and stime fields follow the command name, which can contain spaces.
+    const QByteArray stat = readProcFile(pid, "stat");
+    const QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13) {
+        return 0;
+    }
+    const qint64 ticks = fields[11].toLongLong() + fields[12].toLongLong();
+    return ticks * 1000 / sysconf(_SC_CLK_TCK);
+}
+
+struct Session
+{
+    std::unique_ptr<QProcess> process;
+    qint64 daemonPid = 0;
+};
+
+class DaemonSharedBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void sessions_data();
+    void sessions();
+
+private:
+    QProcessEnvironment sessionEnvironment(bool automaticLocation) const;
+    quint64 sharedProperty(const QString &name) const;
+
+    DaemonProcess m_daemon;
+    QProcess m_systemBus;
+    QString m_systemBusAddress;
+    int m_sessionCount = 200;
+};
+
+void DaemonSharedBenchmark::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The shared instance benchmark must be run on a private session bus");
+    }
+
+    if (const int sessionCount = qEnvironmentVariableIntValue("KNIGHTTIME_SHAREDBENCHMARK_SESSIONS")) {
+        m_sessionCount = sessionCount;
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    m_systemBus.start(QStringLiteral(DBUS_DAEMON_EXECUTABLE), {QStringLiteral("--session"), QStringLiteral("--nofork"), QStringLiteral("--print-address=1")});
+    QVERIFY(m_systemBus.waitForStarted());
+    QVERIFY(m_systemBus.waitForReadyRead());
+    m_systemBusAddress = QString::fromLocal8Bit(m_systemBus.readLine().trimmed());
+    QVERIFY(!m_systemBusAddress.isEmpty());
+
+    // All sessions show the same building, either configured manually or reported by the replayed
+    // position source.
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Location"));
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Latitude"), 50.45);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Longitude"), 30.52);
+    config->sync();
+}
+
+void DaemonSharedBenchmark::cleanupTestCase()
+{
+    QDBusConnection::disconnectFromBus(QStringLiteral("shared-system-bus"));
+    m_systemBus.terminate();
+    m_systemBus.waitForFinished();
+}
+
+QProcessEnvironment DaemonSharedBenchmark::sessionEnvironment(bool automaticLocation) const
+{
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("DBUS_SYSTEM_BUS_ADDRESS"), m_systemBusAddress);
+    if (automaticLocation) {
+        environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY"), QFINDTESTDATA("data/coldstart.nmea"));
+        environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY_SPEED"), QStringLiteral("1"));
+    }
+    return environment;
+}
+
+quint64 DaemonSharedBenchmark::sharedProperty(const QString &name) const
+{
+    QDBusConnection bus = QDBusConnection::connectToBus(m_systemBusAddress, QStringLiteral("shared-system-bus"));
+
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Shared"), QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
+    message.setArguments({QStringLiteral("org.kde.NightTime.Shared"), name});
+
+    const QDBusMessage reply = bus.call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        return 0;
+    }
+    return reply.arguments().constFirst().value<QDBusVariant>().variant().toULongLong();
+}
+
+void DaemonSharedBenchmark::sessions_data()
+{
+    QTest::addColumn<bool>("shared");
+    QTest::addColumn<bool>("automaticLocation");
+
+    QTest::addRow("per-session, manual location") << false << false;
+    QTest::addRow("shared, manual location") << true << false;
+    QTest::addRow("per-session, automatic location") << false << true;
+    QTest::addRow("shared, automatic location") << true << true;
+}
+
+void DaemonSharedBenchmark::sessions()
+{
+    QFETCH(bool, shared);
+    QFETCH(bool, automaticLocation);
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("SharedInstance"), shared);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Automatic"), automaticLocation);
+    config->sync();
+
+    // Every session starts without a known location and uses the times until the first fix.
+    QFile::remove(m_daemon.path(QStringLiteral("state/knighttimestaterc")));
+
+    QProcess systemInstance;
+    if (shared) {
+        systemInstance.setProcessEnvironment(sessionEnvironment(false));
+        systemInstance.setProcessChannelMode(QProcess::ForwardedChannels);
+        systemInstance.start(QStringLiteral(KNIGHTTIMED_EXECUTABLE), {QStringLiteral("--system")});
+        QVERIFY(systemInstance.waitForStarted());
+        QTRY_VERIFY(QDBusConnection::connectToBus(m_systemBusAddress, QStringLiteral("shared-system-bus")).interface()->isServiceRegistered(QStringLiteral("org.kde.NightTime")));
+    }
+
+    std::vector<Session> sessions(m_sessionCount);
+    for (Session &session : sessions) {
+        session.process = std::make_unique<QProcess>();
+        session.process->setProcessEnvironment(sessionEnvironment(automaticLocation));
+        session.process->setProcessChannelMode(QProcess::ForwardedChannels);
+        session.process->start(QStringLiteral(DBUS_RUN_SESSION_EXECUTABLE), {QStringLiteral("--"), QStringLiteral(KNIGHTTIMED_EXECUTABLE)});
+        QVERIFY(session.process->waitForStarted());
+    }
+
+    const QDeadlineTimer deadline(60000);
+    for (Session &session : sessions) {
+        while (!session.daemonPid && !deadline.hasExpired()) {
+            session.daemonPid = findChildProcess(session.process->processId(), QByteArrayLiteral("knighttimed"));
+            if (!session.daemonPid) {
+                QTest::qWait(10);
+            }
+        }
+        QVERIFY(session.daemonPid);
+    }
+
+    // Give every daemon time to load the config and compute the first schedule. With the automatic
+    // location, the schedule for the times is requested before the first position fix.
+    const quint64 configurationCount = automaticLocation ? 2 : 1;
+    if (shared) {
+        QTRY_VERIFY_WITH_TIMEOUT(sharedProperty(QStringLiteral("Requests")) >= configurationCount * m_sessionCount, 60000);
+    }
+    QTest::qWait(3000);
+
+    qint64 totalMemory = 0;
+    qint64 totalCpuTime = 0;
+    for (const Session &session : sessions) {
+        totalMemory += residentMemory(session.daemonPid);
+        totalCpuTime += cpuTime(session.daemonPid);
+    }
+
+    qint64 systemMemory = 0;
+    qint64 systemCpuTime = 0;
+    if (shared) {
+        systemMemory = residentMemory(systemInstance.processId());
+        systemCpuTime = cpuTime(systemInstance.processId());
+        QCOMPARE(sharedProperty(QStringLiteral("Computations")), configurationCount);
+    }
+
+    qInfo("%s, %d sessions: %lld KiB resident and %lldms of CPU time in total, session daemons %lld KiB and %lldms, system instance %lld KiB and %lldms",
+          QTest::currentDataTag(),
+          m_sessionCount,
+          totalMemory + systemMemory,
+          totalCpuTime + systemCpuTime,
+          totalMemory,
+          totalCpuTime,
+          systemMemory,
+          systemCpuTime);
+
+    // Stopping the daemons makes dbus-run-session stop the session bus and exit.
+    for (const Session &session : sessions) {
+        kill(session.daemonPid, SIGTERM);
+    }
+    for (const Session &session : sessions) {
+        session.process->waitForFinished();
+    }
+
+    if (shared) {
+        systemInstance.terminate();
+        systemInstance.waitForFinished();
+    }
+}
+
+QTEST_GUILESS_MAIN(DaemonSharedBenchmark)
+
+#include "daemon_sharedbenchmark.moc"
@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "kdarklightmanager.h"
+#include "knighttimeclock_p.h"
+
+#include <ctime>
+
+using namespace std::chrono_literals;
+
+// The forecasts use the system time zone, pick one with daylight saving time so the simulation
+// crosses both switches. It must be set before anything reads the time zone.
+static void initTimeZone()
+{
+    qputenv("TZ", "Europe/Kyiv");
+}
+Q_CONSTRUCTOR_FUNCTION(initTimeZone)
+
+class DaemonSimulation : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void year_data();
+    void year();
+
+private:
+    QTemporaryDir m_runtimeDir;
+    std::unique_ptr<QTemporaryDir> m_homeDir;
+};
+
+void DaemonSimulation::initTestCase()
+{
+    // Keep the schedule file away from the knighttimed instance that may be running in the session.
+    QVERIFY(m_runtimeDir.isValid());
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(m_runtimeDir.path()));
+
+    const QDateTime winter(QDate(2025, 1, 1), QTime(0, 0));
+    const QDateTime summer(QDate(2025, 7, 1), QTime(0, 0));
+    QCOMPARE_NE(winter.offsetFromUtc(), summer.offsetFromUtc());
+}
+
+void DaemonSimulation::init()
+{
+    // Every run starts with empty settings and a cold schedule cache, so the numbers can be compared.
+    m_homeDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_homeDir->isValid());
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(m_homeDir->filePath(QStringLiteral("config"))));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(m_homeDir->filePath(QStringLiteral("cache"))));
+    qputenv("XDG_STATE_HOME", QFile::encodeName(m_homeDir->filePath(QStringLiteral("state"))));
+    qputenv("XDG_DATA_HOME", QFile::encodeName(m_homeDir->filePath(QStringLiteral("data"))));
+}
+
+void DaemonSimulation::year_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<qreal>("latitude");
+    QTest::addColumn<qreal>("longitude");
+
+    QTest::addRow("times") << QStringLiteral("Times") << 0.0 << 0.0;
+    QTest::addRow("kyiv") << QStringLiteral("Location") << 50.45 << 30.52;
+    QTest::addRow("tromso") << QStringLiteral("Location") << 69.65 << 18.96;
+}
+
+void DaemonSimulation::year()
+{
+    QFETCH(QString, source);
+    QFETCH(qreal, latitude);
+    QFETCH(qreal, longitude);
+
+    const KSharedConfig::Ptr config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    KConfigGroup general(config, QStringLiteral("General"));
+    general.writeEntry(QStringLiteral("Source"), source);
+    KConfigGroup location(config, QStringLiteral("Location"));
+    location.writeEntry(QStringLiteral("Automatic"), false);
+    location.writeEntry(QStringLiteral("Latitude"), latitude);
+    location.writeEntry(QStringLiteral("Longitude"), longitude);
+    config->sync();
+
+    KNightTimeVirtualClock clock(QDateTime(QDate(2025, 1, 1), QTime(0, 0)));
+
+    KDarkLightManager manager(&clock);
+    manager.reconfigure();
+
+    const std::clock_t cpuStart = std::clock();
+
+    for (int day = 0; day < 365; ++day) {
+        // Every month, the clock jumps as if the user has changed the time manually.
+        if (day && day % 30 == 0) {
+            clock.skew(day % 60 ? 3h : -3h);
+        }
+
+        for (int step = 0; step < 96; ++step) {
+            clock.advance(15min);
+
+            const QDateTime now = clock.currentDateTime();
+            const QList<KDarkLightCycle> cycles = manager.schedule().cycles();
+            QVERIFY2(!cycles.isEmpty(), qPrintable(now.toString(Qt::ISODate)));
+            QVERIFY2(cycles.first().morning().startDateTime() <= now, qPrintable(now.toString(Qt::ISODate)));
+            QVERIFY2(now.addDays(1) <= cycles.last().evening().endDateTime(), qPrintable(now.toString(Qt::ISODate)));
+        }
+    }
+
+    const std::clock_t cpuEnd = std::clock();
+
+    const KDarkLightMetrics *metrics = manager.metrics();
+    const QVariantMap reschedule = metrics->reschedule.toVariantMap();
+    qInfo("%s: 365 days, %llu reschedules (forecasts) taking %llu us in total, %llu schedule changes (Refreshed fan-outs), %lld us of CPU time overall",
+          QTest::currentDataTag(),
+          reschedule.value(QStringLiteral("Count")).toULongLong(),
+          reschedule.value(QStringLiteral("TotalUsec")).toULongLong(),
+          metrics->scheduleChanges,
+          qint64(cpuEnd - cpuStart) * 1000000 / CLOCKS_PER_SEC);
+}
+
+QTEST_GUILESS_MAIN(DaemonSimulation)
+
+#include "daemon_simulation.moc"
@@ -0,0 +1,196 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+#include <signal.h>
+
+using namespace std::chrono_literals;
+
+/*
+ * The mock logind service lives in the test process, the daemon is told to look for it on the
+ * session bus.
+ */
+static void prepareForSleep(bool sleep)
+{
+    auto signal = QDBusMessage::createSignal(QStringLiteral("/org/freedesktop/login1"), QStringLiteral("org.freedesktop.login1.Manager"), QStringLiteral("PrepareForSleep"));
+    signal.setArguments({sleep});
+    QDBusConnection::sessionBus().send(signal);
+}
+
+static quint64 histogramCount(const QVariantMap &metrics, const QString &name)
+{
+    return qdbus_cast<QVariantMap>(metrics.value(name)).value(QStringLiteral("Count")).toULongLong();
+}
+
+static quint64 counter(const QVariantMap &metrics, const QString &name)
+{
+    return metrics.value(name).toULongLong();
+}
+
+class DaemonSleepTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void changesDuringSleep();
+    void noChangesDuringSleep();
+    void logindGoneDuringSleep();
+    void lateTimers();
+
+private:
+    void reconfigure(int transitionDuration);
+
+    DaemonProcess m_daemon;
+    std::unique_ptr<DaemonClient> m_client;
+};
+
+void DaemonSleepTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The sleep test must be run on a private session bus");
+    }
+
+    QVERIFY(m_daemon.isValid());
+    QVERIFY(QDBusConnection::sessionBus().registerService(QStringLiteral("org.freedesktop.login1")));
+
+    // The coalescing window is wide, so a refresh sent after it would be easy to tell apart.
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Times"));
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("RefreshCoalescingInterval"), 5000);
+    config->sync();
+
+    QProcessEnvironment environment;
+    environment.insert(QStringLiteral("KNIGHTTIMED_LOGIND_BUS"), QStringLiteral("session"));
+    QVERIFY(m_daemon.start(environment));
+
+    m_client = std::make_unique<DaemonClient>(QStringLiteral("sleep-client"));
+    QVERIFY(m_client->subscribe());
+}
+
+void DaemonSleepTest::cleanupTestCase()
+{
+    m_client.reset();
+    m_daemon.stop();
+}
+
+void DaemonSleepTest::init()
+{
+    m_client->refreshCount = 0;
+}
+
+void DaemonSleepTest::reconfigure(int transitionDuration)
+{
+    const quint64 before = histogramCount(m_daemon.metrics(), QStringLiteral("Reconfigure"));
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("Times")).writeEntry(QStringLiteral("TransitionDuration"), transitionDuration, KConfig::Notify);
+    config->sync();
+
+    QTRY_VERIFY(histogramCount(m_daemon.metrics(), QStringLiteral("Reconfigure")) > before);
+}
+
+void DaemonSleepTest::changesDuringSleep()
+{
+    const QVariantMap before = m_daemon.metrics();
+
+    prepareForSleep(true);
+    QTRY_COMPARE(counter(m_daemon.metrics(), QStringLiteral("Sleeps")), counter(before, QStringLiteral("Sleeps")) + 1);
+
+    // The schedule changes a couple of times while the system is going to sleep.
+    reconfigure(1200);
+    reconfigure(600);
+    QTest::qWait(6000);
+    QCOMPARE(m_client->refreshCount, 0);
+
+    const auto resumeTime = std::chrono::steady_clock::now();
+    prepareForSleep(false);
+
+    QTRY_COMPARE(m_client->refreshCount, 1);
+    const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(m_client->lastRefreshTime - resumeTime);
+    qInfo("Refreshed after resume in %lldms", qint64(latency.count()));
+    QVERIFY(latency < 5000ms);
+
+    // No more signals are sent after the coalescing window.
+    QTest::qWait(6000);
+    QCOMPARE(m_client->refreshCount, 1);
+
+    const QVariantMap after = m_daemon.metrics();
+    QCOMPARE(histogramCount(after, QStringLiteral("Resume")), histogramCount(before, QStringLiteral("Resume")) + 1);
+    QCOMPARE(counter(after, QStringLiteral("ScheduleChanges")), counter(before, QStringLiteral("ScheduleChanges")) + 2);
+    QCOMPARE(counter(after, QStringLiteral("RefreshedSignals")), counter(before, QStringLiteral("RefreshedSignals")) + 1);
+}
+
+void DaemonSleepTest::noChangesDuringSleep()
+{
+    const QVariantMap before = m_daemon.metrics();
+
+    prepareForSleep(true);
+    QTRY_COMPARE(counter(m_daemon.metrics(), QStringLiteral("Sleeps")), counter(before, QStringLiteral("Sleeps")) + 1);
+    prepareForSleep(false);
+    QTRY_COMPARE(histogramCount(m_daemon.metrics(), QStringLiteral("Resume")), histogramCount(before, QStringLiteral("Resume")) + 1);
+
+    // The schedule is the same, so there is nothing to tell the subscribers.
+    QTest::qWait(1000);
+    QCOMPARE(m_client->refreshCount, 0);
+    QCOMPARE(counter(m_daemon.metrics(), QStringLiteral("RefreshedSignals")), counter(before, QStringLiteral("RefreshedSignals")));
+}
+
+void DaemonSleepTest::logindGoneDuringSleep()
+{
+    const QVariantMap before = m_daemon.metrics();
+
+    prepareForSleep(true);
+    QTRY_COMPARE(counter(m_daemon.metrics(), QStringLiteral("Sleeps")), counter(before, QStringLiteral("Sleeps")) + 1);
+    reconfigure(900);
+
+    // The resume signal will never arrive if logind goes away.
+    QVERIFY(QDBusConnection::sessionBus().unregisterService(QStringLiteral("org.freedesktop.login1")));
+    QTRY_COMPARE(histogramCount(m_daemon.metrics(), QStringLiteral("Resume")), histogramCount(before, QStringLiteral("Resume")) + 1);
+    QTRY_COMPARE(m_client->refreshCount, 1);
+
+    QVERIFY(QDBusConnection::sessionBus().registerService(QStringLiteral("org.freedesktop.login1")));
+}
+
+void DaemonSleepTest::lateTimers()
+{
+    const QVariantMap before = m_daemon.metrics();
+
+    // The daemon is frozen in the middle of the coalescing window, e.g. because the system has been
+    // suspended without a PrepareForSleep signal. The timer fires late, but only once.
+    reconfigure(300);
+    QVERIFY(::kill(m_daemon.processId(), SIGSTOP) == 0);
+    QTest::qWait(7000);
+    QCOMPARE(m_client->refreshCount, 0);
+
+    const auto continueTime = std::chrono::steady_clock::now();
+    QVERIFY(::kill(m_daemon.processId(), SIGCONT) == 0);
+
+    QTRY_COMPARE(m_client->refreshCount, 1);
+    const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(m_client->lastRefreshTime - continueTime);
+    qInfo("Refreshed after the daemon has been continued in %lldms", qint64(latency.count()));
+    QVERIFY(latency < 1000ms);
+
+    QTest::qWait(6000);
+    QCOMPARE(m_client->refreshCount, 1);
+    QCOMPARE(counter(m_daemon.metrics(), QStringLiteral("RefreshedSignals")), counter(before, QStringLiteral("RefreshedSignals")) + 1);
+}
+
+QTEST_GUILESS_MAIN(DaemonSleepTest)
+
+#include "daemon_sleeptest.moc"
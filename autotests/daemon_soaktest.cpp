@@ -0,0 +1,262 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVariant>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+#include "kdarklightscheduleprovider.h"
+#include "kdarklightschedulesubscription_p.h"
+
+#include <algorithm>
+
+static QDBusMessage createMethodCall(const QString &method)
+{
+    return QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), method);
+}
+
+static uint leaseCount()
+{
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Debug"), QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
+    message.setArguments({QStringLiteral("org.kde.NightTime.Debug"), QStringLiteral("Leases")});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        return -1;
+    }
+    return reply.arguments().constFirst().value<QDBusVariant>().variant().toUInt();
+}
+
+static quint64 histogramCount(const QVariantMap &metrics, const QString &name)
+{
+    return qdbus_cast<QVariantMap>(metrics.value(name)).value(QStringLiteral("Count")).toULongLong();
+}
+
+static quint64 counter(const QVariantMap &metrics, const QString &name)
+{
+    return metrics.value(name).toULongLong();
+}
+
+class DaemonSoakTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void leaseExpiry();
+    void leaseRenewal();
+    void leaseShrink();
+    void stoppedClient();
+    void providers();
+
+private:
+    uint subscribe(bool lease);
+    bool renew(uint cookie);
+    void setLeaseDuration(uint duration);
+
+    DaemonProcess m_daemon;
+    uint m_leaseDuration = 2;
+    // A million providers take a while, that run is opt-in.
+    int m_providerCount = 1000;
+};
+
+void DaemonSoakTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The soak test must be run on a private session bus");
+    }
+
+    if (const int providerCount = qEnvironmentVariableIntValue("KNIGHTTIME_SOAKTEST_PROVIDERS")) {
+        m_providerCount = providerCount;
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Times"));
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("SubscriptionLeaseDuration"), m_leaseDuration);
+    config->sync();
+
+    QVERIFY(m_daemon.start());
+}
+
+void DaemonSoakTest::cleanupTestCase()
+{
+    m_daemon.stop();
+}
+
+uint DaemonSoakTest::subscribe(bool lease)
+{
+    auto message = createMethodCall(QStringLiteral("Subscribe"));
+    message.setArguments({QVariantMap{
+        {QStringLiteral("Lease"), lease},
+    }});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    const QVariantMap results = qdbus_cast<QVariantMap>(reply.arguments().value(0));
+    if (lease) {
+        // An unexpected value would make the timing below meaningless.
+        if (results.value(QStringLiteral("LeaseDuration")).toUInt() != m_leaseDuration) {
+            return -1;
+        }
+    }
+    return results.value(QStringLiteral("Cookie"), -1).toUInt();
+}
+
+bool DaemonSoakTest::renew(uint cookie)
+{
+    auto message = createMethodCall(QStringLiteral("Renew"));
+    message.setArguments({cookie});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    return reply.type() == QDBusMessage::ReplyMessage && reply.arguments().constFirst().toBool();
+}
+
+void DaemonSoakTest::setLeaseDuration(uint duration)
+{
+    const quint64 before = histogramCount(m_daemon.metrics(), QStringLiteral("Reconfigure"));
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("SubscriptionLeaseDuration"), duration, KConfig::Notify);
+    config->sync();
+
+    QTRY_VERIFY(histogramCount(m_daemon.metrics(), QStringLiteral("Reconfigure")) > before);
+    m_leaseDuration = duration;
+}
+
+void DaemonSoakTest::leaseExpiry()
+{
+    // This process stays connected to the bus, so only the lease can end the subscription.
+    const uint cookie = subscribe(true);
+    QVERIFY(cookie != uint(-1));
+    QCOMPARE(leaseCount(), 1u);
+    QCOMPARE(m_daemon.subscriberCount(), 1u);
+
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 5000);
+    QCOMPARE(leaseCount(), 0u);
+    QVERIFY(!renew(cookie));
+
+    // Subscriptions without a lease are not affected.
+    const uint unleasedCookie = subscribe(false);
+    QVERIFY(unleasedCookie != uint(-1));
+    QVERIFY(!renew(unleasedCookie));
+    QTest::qWait(3000);
+    QCOMPARE(m_daemon.subscriberCount(), 1u);
+
+    auto unsubscribe = createMethodCall(QStringLiteral("Unsubscribe"));
+    unsubscribe.setArguments({unleasedCookie});
+    QDBusConnection::sessionBus().call(unsubscribe);
+    QCOMPARE(m_daemon.subscriberCount(), 0u);
+}
+
+void DaemonSoakTest::leaseRenewal()
+{
+    const uint cookie = subscribe(true);
+    QVERIFY(cookie != uint(-1));
+
+    for (int i = 0; i < 6; ++i) {
+        QTest::qWait(1000);
+        QVERIFY(renew(cookie));
+        QCOMPARE(m_daemon.subscriberCount(), 1u);
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 5000);
+    QCOMPARE(leaseCount(), 0u);
+}
+
+void DaemonSoakTest::leaseShrink()
+{
+    setLeaseDuration(60);
+    const uint longCookie = subscribe(true);
+    QVERIFY(longCookie != uint(-1));
+
+    // The lease that has been taken before the change must not hold back the expiry of the new one.
+    setLeaseDuration(2);
+    const uint shortCookie = subscribe(true);
+    QVERIFY(shortCookie != uint(-1));
+    QCOMPARE(leaseCount(), 2u);
+
+    QElapsedTimer expiryTimer;
+    expiryTimer.start();
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 5000);
+    QVERIFY(expiryTimer.elapsed() < 4000);
+    QCOMPARE(leaseCount(), 0u);
+}
+
+void DaemonSoakTest::stoppedClient()
+{
+    KDarkLightScheduleSubscription subscription;
+    QSignalSpy refreshedSpy(&subscription, &KDarkLightScheduleSubscription::refreshed);
+    QVERIFY(refreshedSpy.wait());
+    QCOMPARE(m_daemon.subscriberCount(), 1u);
+
+    // The client neither unsubscribes nor leaves the bus, but it does not run for longer than its
+    // lease, e.g. because it has been stopped in a debugger.
+    const quint64 expiredLeases = counter(m_daemon.metrics(), QStringLiteral("ExpiredLeases"));
+    QThread::sleep(std::chrono::seconds(m_leaseDuration * 2));
+    QCOMPARE(m_daemon.subscriberCount(), 0u);
+    QCOMPARE(counter(m_daemon.metrics(), QStringLiteral("ExpiredLeases")), expiredLeases + 1);
+
+    // Once the client runs again, its renewal is rejected and it subscribes again.
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 1u, 5000);
+}
+
+void DaemonSoakTest::providers()
+{
+    // The daemon memory usage is measured once the allocator has warmed up.
+    const int warmUpCount = m_providerCount / 10;
+    qint64 warmMemory = 0;
+
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+    const QVariantMap initialMetrics = m_daemon.metrics();
+
+    for (int i = 0; i < m_providerCount; ++i) {
+        // Wait for the Subscribe() reply, so the provider goes away with a proper Unsubscribe() call.
+        {
+            KDarkLightScheduleProvider provider;
+            const auto subscription = KDarkLightScheduleSubscription::globalSubscription();
+            QSignalSpy refreshedSpy(subscription.get(), &KDarkLightScheduleSubscription::refreshed);
+            QVERIFY(refreshedSpy.wait());
+        }
+
+        if (i + 1 == warmUpCount) {
+            QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+            warmMemory = m_daemon.residentMemory();
+        }
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(m_daemon.subscriberCount(), 0u, 10000);
+    QCOMPARE(leaseCount(), 0u);
+
+    const QVariantMap metrics = m_daemon.metrics();
+    QCOMPARE(counter(metrics, QStringLiteral("UnsubscribeCalls")), counter(initialMetrics, QStringLiteral("UnsubscribeCalls")) + m_providerCount);
+    QCOMPARE(counter(metrics, QStringLiteral("ExpiredLeases")), counter(initialMetrics, QStringLiteral("ExpiredLeases")));
+    const qint64 finalMemory = m_daemon.residentMemory();
+    qInfo("%d providers: daemon resident memory %lld KiB after %d providers, %lld KiB at the end, %llu Unsubscribe() calls, %llu expired leases",
+          m_providerCount,
+          warmMemory / 1024,
+          warmUpCount,
+          finalMemory / 1024,
+          metrics.value(QStringLiteral("UnsubscribeCalls")).toULongLong(),
+          metrics.value(QStringLiteral("ExpiredLeases")).toULongLong());
+
+    // Allow for some noise, a leak of one small allocation per subscription would be much larger.
+    QVERIFY(finalMemory <= warmMemory + std::max<qint64>(warmMemory / 10, 4 * 1024 * 1024));
+}
+
+QTEST_GUILESS_MAIN(DaemonSoakTest)
+
+#include "daemon_soaktest.moc"
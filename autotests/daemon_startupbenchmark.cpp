@@ -0,0 +1,230 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+#include <chrono>
+
+/*
+ * The daemon writes a trace for every run. The trace timestamps come from the monotonic clock, so
+ * they can be compared with the time when the process has been started.
+ */
+
+static qint64 timestamp()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static QHash<QString, QJsonObject> readTrace(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    // The daemon is terminated, so the trace is not closed. Every event is on its own line though.
+    QHash<QString, QJsonObject> events;
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (QByteArray line : lines) {
+        if (line.endsWith(',')) {
+            line.chop(1);
+        }
+        if (!line.startsWith('{')) {
+            continue;
+        }
+
+        const QJsonObject event = QJsonDocument::fromJson(line).object();
+        if (event.value(QStringLiteral("ph")).toString() == QLatin1String("X")) {
+            const QString name = event.value(QStringLiteral("name")).toString();
+            if (!events.contains(name)) {
+                events.insert(name, event);
+            }
+        }
+    }
+
+    return events;
+}
+
+static int transitionCount()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("GetTransitions"));
+    message.setArguments({now.addDays(-1).toMSecsSinceEpoch(), now.addDays(1).toMSecsSinceEpoch()});
+
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        return -1;
+    }
+
+    const QDBusArgument argument = reply.arguments().constFirst().value<QDBusArgument>();
+    int count = 0;
+    argument.beginArray();
+    while (!argument.atEnd()) {
+        uint type;
+        qint64 start;
+        qint64 end;
+        argument.beginStructure();
+        argument >> type >> start >> end;
+        argument.endStructure();
+        count++;
+    }
+    argument.endArray();
+
+    return count;
+}
+
+class DaemonStartupBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void coldStart_data();
+    void coldStart();
+
+private:
+    DaemonProcess m_daemon;
+    int m_runCount = 20;
+};
+
+void DaemonStartupBenchmark::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The startup benchmark must be run on a private session bus");
+    }
+
+    if (const int runCount = qEnvironmentVariableIntValue("KNIGHTTIME_STARTUPBENCHMARK_RUNS")) {
+        m_runCount = runCount;
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    // An unrelated Night Light setting, so the migration has a real file to look at.
+    auto kwinrc = KSharedConfig::openConfig(QStringLiteral("kwinrc"));
+    kwinrc->group(QStringLiteral("NightColor")).writeEntry(QStringLiteral("Active"), true);
+    kwinrc->sync();
+}
+
+void DaemonStartupBenchmark::coldStart_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<bool>("automaticLocation");
+    QTest::addColumn<bool>("firstStart");
+
+    QTest::addRow("times") << QStringLiteral("Times") << false << false;
+    QTest::addRow("manual location") << QStringLiteral("Location") << false << false;
+    QTest::addRow("automatic location") << QStringLiteral("Location") << true << false;
+    QTest::addRow("first start") << QStringLiteral("Times") << false << true;
+}
+
+void DaemonStartupBenchmark::coldStart()
+{
+    QFETCH(QString, source);
+    QFETCH(bool, automaticLocation);
+    QFETCH(bool, firstStart);
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), source);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Automatic"), automaticLocation);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Latitude"), 50.45);
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Longitude"), 30.52);
+    config->sync();
+
+    const QString traceFileName = m_daemon.path(QStringLiteral("startup-trace.json"));
+    const QString stateFileName = m_daemon.path(QStringLiteral("state/knighttimestaterc"));
+
+    QProcessEnvironment environment;
+    environment.insert(QStringLiteral("KNIGHTTIME_TRACE_FILE"), traceFileName);
+
+    const QStringList phases{
+        QStringLiteral("initialize"),
+        QStringLiteral("loadSettings"),
+        QStringLiteral("loadState"),
+        QStringLiteral("migrateConfig"),
+        QStringLiteral("createPositionSource"),
+        QStringLiteral("forecast"),
+        QStringLiteral("reconfigure"),
+        QStringLiteral("registerService"),
+    };
+    QHash<QString, qint64> phaseTotals;
+    QHash<QString, int> phaseCounts;
+    qint64 execToMainTotal = 0;
+    qint64 execToRegisteredTotal = 0;
+    qint64 execToScheduleTotal = 0;
+
+    // The first run warms up the page cache and does the one-time migration, it is not counted.
+    for (int i = 0; i <= m_runCount; ++i) {
+        QFile::remove(traceFileName);
+        if (firstStart) {
+            QFile::remove(stateFileName);
+        }
+
+        const qint64 execTimestamp = timestamp();
+        QVERIFY(m_daemon.start(environment));
+
+        // The schedule must be available as soon as the service is on the bus.
+        QVERIFY(transitionCount() > 0);
+        const qint64 scheduleTimestamp = timestamp();
+
+        m_daemon.stop();
+        if (i == 0) {
+            continue;
+        }
+
+        const QHash<QString, QJsonObject> events = readTrace(traceFileName);
+        QVERIFY(events.contains(QStringLiteral("initialize")));
+        QVERIFY(events.contains(QStringLiteral("registerService")));
+
+        for (const QString &phase : phases) {
+            if (const auto it = events.constFind(phase); it != events.constEnd()) {
+                phaseTotals[phase] += it->value(QStringLiteral("dur")).toInteger();
+                phaseCounts[phase]++;
+            }
+        }
+
+        const QJsonObject initialize = events.value(QStringLiteral("initialize"));
+        const QJsonObject registerService = events.value(QStringLiteral("registerService"));
+        execToMainTotal += initialize.value(QStringLiteral("ts")).toInteger() - execTimestamp;
+        execToRegisteredTotal += registerService.value(QStringLiteral("ts")).toInteger() + registerService.value(QStringLiteral("dur")).toInteger() - execTimestamp;
+        execToScheduleTotal += scheduleTimestamp - execTimestamp;
+    }
+
+    qInfo("%s, %d runs: exec to main %.2fms, exec to registered service %.2fms, exec to first GetTransitions() reply %.2fms",
+          QTest::currentDataTag(),
+          m_runCount,
+          execToMainTotal / 1000.0 / m_runCount,
+          execToRegisteredTotal / 1000.0 / m_runCount,
+          execToScheduleTotal / 1000.0 / m_runCount);
+    for (const QString &phase : phases) {
+        const int count = phaseCounts.value(phase);
+        qInfo("    %-22s %8.2fms on average, in %d of %d runs",
+              qPrintable(phase),
+              count ? phaseTotals.value(phase) / 1000.0 / count : 0.0,
+              count,
+              m_runCount);
+    }
+
+    // The migration runs only once, unless the state is lost.
+    QCOMPARE(phaseCounts.value(QStringLiteral("migrateConfig")), firstStart ? m_runCount : 0);
+}
+
+QTEST_GUILESS_MAIN(DaemonStartupBenchmark)
+
+#include "daemon_startupbenchmark.moc"
@@ -0,0 +1,130 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QTest>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include "daemonprocess.h"
+
+using namespace std::chrono_literals;
+
+// It takes the receiver 5 seconds to get the first fix.
+static QProcessEnvironment replayEnvironment()
+{
+    QProcessEnvironment environment;
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY"), QFINDTESTDATA("data/coldstart.nmea"));
+    environment.insert(QStringLiteral("KNIGHTTIMED_POSITION_REPLAY_SPEED"), QStringLiteral("1"));
+    return environment;
+}
+
+class DaemonWaitForAccurateTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void waitForAccurate();
+    void idleWhileWaiting();
+
+private:
+    DaemonProcess m_daemon;
+};
+
+void DaemonWaitForAccurateTest::initTestCase()
+{
+    if (!DaemonProcess::isPrivateBus()) {
+        QSKIP("The WaitForAccurate test must be run on a private session bus");
+    }
+
+    QVERIFY(m_daemon.isValid());
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("Source"), QStringLiteral("Location"));
+    config->group(QStringLiteral("Location")).writeEntry(QStringLiteral("Automatic"), true);
+    config->sync();
+
+    QVERIFY(m_daemon.start(replayEnvironment()));
+}
+
+void DaemonWaitForAccurateTest::cleanupTestCase()
+{
+    m_daemon.stop();
+}
+
+void DaemonWaitForAccurateTest::waitForAccurate()
+{
+    // A client that does not wait gets the placeholder schedule and then the real one.
+    DaemonClient impatientClient(QStringLiteral("waitforaccurate-client-0"));
+    impatientClient.asyncSubscribe({{QStringLiteral("WaitForAccurate"), 0u}});
+
+    // This client gives up waiting before the first fix.
+    DaemonClient hastyClient(QStringLiteral("waitforaccurate-client-1"));
+    hastyClient.asyncSubscribe({{QStringLiteral("WaitForAccurate"), 500u}});
+
+    // And this one waits long enough.
+    DaemonClient patientClient(QStringLiteral("waitforaccurate-client-2"));
+    patientClient.asyncSubscribe({{QStringLiteral("WaitForAccurate"), 15000u}});
+
+    QTRY_VERIFY(impatientClient.replied);
+    QCOMPARE(impatientClient.results.value(QStringLiteral("Accurate")).toBool(), false);
+
+    QTRY_VERIFY(hastyClient.replied);
+    QCOMPARE(hastyClient.results.value(QStringLiteral("Accurate")).toBool(), false);
+    QVERIFY(!patientClient.replied);
+
+    QTRY_VERIFY_WITH_TIMEOUT(patientClient.replied, 15000);
+    QCOMPARE(patientClient.results.value(QStringLiteral("Accurate")).toBool(), true);
+    QVERIFY(patientClient.results.contains(QStringLiteral("Schedule")));
+
+    // Wait for the coalescing window to close.
+    QTest::qWait(2000);
+
+    qInfo("Subscribe() latency: %lldms without waiting, %lldms with a 500ms timeout, %lldms with waiting for the location",
+          qint64(std::chrono::duration_cast<std::chrono::milliseconds>(impatientClient.latency).count()),
+          qint64(std::chrono::duration_cast<std::chrono::milliseconds>(hastyClient.latency).count()),
+          qint64(std::chrono::duration_cast<std::chrono::milliseconds>(patientClient.latency).count()));
+
+    QCOMPARE(impatientClient.refreshCount, 1);
+    QCOMPARE(hastyClient.refreshCount, 1);
+    QCOMPARE(patientClient.refreshCount, 0);
+
+    // The schedule is accurate now, so there is nothing to wait for.
+    DaemonClient lateClient(QStringLiteral("waitforaccurate-client-3"));
+    lateClient.asyncSubscribe({{QStringLiteral("WaitForAccurate"), 15000u}});
+    QTRY_VERIFY(lateClient.replied);
+    QCOMPARE(lateClient.results.value(QStringLiteral("Accurate")).toBool(), true);
+    QVERIFY(lateClient.latency < 1s);
+}
+
+void DaemonWaitForAccurateTest::idleWhileWaiting()
+{
+    // Start over without the last known location, with an idle timeout much shorter than the time
+    // it takes to get the first fix.
+    m_daemon.stop();
+    QFile::remove(m_daemon.path(QStringLiteral("state/knighttimestaterc")));
+
+    auto config = KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals);
+    config->group(QStringLiteral("General")).writeEntry(QStringLiteral("IdleTimeout"), 1);
+    config->sync();
+
+    QVERIFY(m_daemon.start(replayEnvironment()));
+
+    // The client that waits for the reply keeps the daemon running.
+    DaemonClient client(QStringLiteral("waitforaccurate-client-4"));
+    client.asyncSubscribe({{QStringLiteral("WaitForAccurate"), 15000u}});
+    QTRY_VERIFY_WITH_TIMEOUT(client.replied, 15000);
+    QVERIFY(m_daemon.isRunning());
+    QCOMPARE(client.results.value(QStringLiteral("Accurate")).toBool(), true);
+}
+
+QTEST_GUILESS_MAIN(DaemonWaitForAccurateTest)
+
+#include "daemon_waitforaccuratetest.moc"
@@ -0,0 +1,191 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "daemonprocess.h"
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusReply>
+#include <QDeadlineTimer>
+#include <QFile>
+#include <QThread>
+
+DaemonProcess::DaemonProcess()
+{
+    qputenv("XDG_CONFIG_HOME", m_homeDir.filePath(QStringLiteral("config")).toLocal8Bit());
+    qputenv("XDG_STATE_HOME", m_homeDir.filePath(QStringLiteral("state")).toLocal8Bit());
+    qputenv("XDG_CACHE_HOME", m_homeDir.filePath(QStringLiteral("cache")).toLocal8Bit());
+    qputenv("XDG_RUNTIME_DIR", m_homeDir.path().toLocal8Bit());
+
+    m_process.setProcessChannelMode(QProcess::ForwardedChannels);
+}
+
+DaemonProcess::~DaemonProcess()
+{
+    stop();
+}
+
+bool DaemonProcess::isPrivateBus()
+{
+    return qEnvironmentVariableIsSet("KNIGHTTIME_PRIVATE_BUS");
+}
+
+bool DaemonProcess::isValid() const
+{
+    return m_homeDir.isValid();
+}
+
+QString DaemonProcess::path(const QString &fileName) const
+{
+    return m_homeDir.filePath(fileName);
+}
+
+bool DaemonProcess::start(const QProcessEnvironment &environment)
+{
+    QProcessEnvironment effectiveEnvironment = QProcessEnvironment::systemEnvironment();
+    effectiveEnvironment.insert(QStringLiteral("KNIGHTTIMED_DEBUG_INTERFACE"), QStringLiteral("1"));
+    effectiveEnvironment.insert(environment);
+
+    m_process.setProcessEnvironment(effectiveEnvironment);
+    m_process.start(QStringLiteral(KNIGHTTIMED_EXECUTABLE), QStringList());
+    if (!m_process.waitForStarted()) {
+        return false;
+    }
+
+    const QDeadlineTimer deadline(10000);
+    while (!QDBusConnection::sessionBus().interface()->isServiceRegistered(QStringLiteral("org.kde.NightTime"))) {
+        if (deadline.hasExpired() || m_process.state() == QProcess::NotRunning) {
+            return false;
+        }
+        QThread::msleep(10);
+    }
+
+    return true;
+}
+
+void DaemonProcess::stop()
+{
+    if (m_process.state() != QProcess::NotRunning) {
+        m_process.terminate();
+        m_process.waitForFinished();
+    }
+}
+
+bool DaemonProcess::isRunning() const
+{
+    return m_process.state() != QProcess::NotRunning;
+}
+
+qint64 DaemonProcess::processId() const
+{
+    return m_process.processId();
+}
+
+QVariantMap DaemonProcess::metrics() const
+{
+    const auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Debug"), QStringLiteral("org.kde.NightTime.Debug"), QStringLiteral("GetMetrics"));
+    const QDBusMessage reply = QDBusConnection::sessionBus().call(message);
+    if (reply.type() != QDBusMessage::ReplyMessage) {
+        return QVariantMap();
+    }
+    return qdbus_cast<QVariantMap>(reply.arguments().constFirst());
+}
+
+uint DaemonProcess::subscriberCount() const
+{
+    return metrics().value(QStringLiteral("Subscribers"), -1).toUInt();
+}
+
+qint64 DaemonProcess::residentMemory() const
+{
+    QFile status(QStringLiteral("/proc/%1/status").arg(m_process.processId()));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').constFirst().toLongLong() * 1024;
+        }
+    }
+
+    return -1;
+}
+
+static QDBusMessage createSubscribeMessage(const QVariantMap &options)
+{
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Subscribe"));
+    message.setArguments({options});
+    return message;
+}
+
+DaemonClient::DaemonClient(const QString &name)
+    : m_name(name)
+    , m_connection(QDBusConnection::connectToBus(QDBusConnection::SessionBus, m_name))
+{
+    m_connection.connect(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Refreshed"), this, SLOT(OnRefreshed(QVariantMap)));
+}
+
+DaemonClient::~DaemonClient()
+{
+    QDBusConnection::disconnectFromBus(m_name);
+}
+
+bool DaemonClient::isConnected() const
+{
+    return m_connection.isConnected();
+}
+
+bool DaemonClient::subscribe(const QVariantMap &options)
+{
+    const auto sendTime = std::chrono::steady_clock::now();
+    const QDBusReply<QVariantMap> reply = m_connection.call(createSubscribeMessage(options));
+    latency = std::chrono::steady_clock::now() - sendTime;
+
+    if (!reply.isValid()) {
+        return false;
+    }
+
+    results = reply.value();
+    m_cookie = results.value(QStringLiteral("Cookie")).toUInt();
+    return results.contains(QStringLiteral("Cookie"));
+}
+
+void DaemonClient::asyncSubscribe(const QVariantMap &options)
+{
+    const auto sendTime = std::chrono::steady_clock::now();
+    auto watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(createSubscribeMessage(options)), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, sendTime](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        latency = std::chrono::steady_clock::now() - sendTime;
+
+        const QDBusPendingReply<QVariantMap> reply = *watcher;
+        if (!reply.isError()) {
+            results = reply.value();
+            m_cookie = results.value(QStringLiteral("Cookie")).toUInt();
+        }
+        replied = true;
+    });
+}
+
+void DaemonClient::unsubscribe()
+{
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Unsubscribe"));
+    message.setArguments({m_cookie});
+    m_connection.call(message);
+}
+
+void DaemonClient::OnRefreshed(const QVariantMap &data)
+{
+    refreshCount++;
+    lastRefreshTime = std::chrono::steady_clock::now();
+}
+
+#include "moc_daemonprocess.cpp"
@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QVariantMap>
+
+#include <chrono>
+
+/*
+ * The DaemonProcess runs knighttimed with isolated XDG directories. The XDG environment variables of
+ * the test process are changed as well, so the test can write the config files read by the daemon.
+ *
+ * It must be used only on a private session bus, see dbus-run-session.
+ */
+class DaemonProcess
+{
+public:
+    DaemonProcess();
+    ~DaemonProcess();
+
+    static bool isPrivateBus();
+
+    bool isValid() const;
+    QString path(const QString &fileName) const;
+
+    bool start(const QProcessEnvironment &environment = QProcessEnvironment());
+    void stop();
+    bool isRunning() const;
+    qint64 processId() const;
+
+    QVariantMap metrics() const;
+    uint subscriberCount() const;
+    qint64 residentMemory() const;
+
+private:
+    QTemporaryDir m_homeDir;
+    QProcess m_process;
+};
+
+/*
+ * The DaemonClient talks to knighttimed over its own bus connection, so every client is seen by the
+ * daemon as a separate application. The Refreshed signals received by the client are counted.
+ */
+class DaemonClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DaemonClient(const QString &name);
+    ~DaemonClient() override;
+
+    bool isConnected() const;
+
+    /*
+     * Calls Subscribe() and waits for the reply. The round trip time is stored in latency.
+     */
+    bool subscribe(const QVariantMap &options = QVariantMap());
+
+    /*
+     * Sends the Subscribe() call without blocking. Once the reply arrives, replied is set, and the
+     * results and the round trip time are stored in results and latency.
+     */
+    void asyncSubscribe(const QVariantMap &options = QVariantMap());
+
+    void unsubscribe();
+
+    bool replied = false;
+    QVariantMap results;
+    std::chrono::nanoseconds latency = std::chrono::nanoseconds::zero();
+    int refreshCount = 0;
+    std::chrono::steady_clock::time_point lastRefreshTime;
+
+private Q_SLOTS:
+    void OnRefreshed(const QVariantMap &data);
+
+private:
+    QString m_name;
+    QDBusConnection m_connection;
+    uint m_cookie = 0;
+};
@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "fakescheduledaemon.h"
+#include "kdarklightschedulefile_p.h"
+#include "kdarklightschedulesubscription_p.h"
+
+FakeScheduleDaemon::FakeScheduleDaemon(const QString &fileName)
+    : m_fileName(fileName)
+    , m_writer(KDarkLightScheduleFile::create(fileName))
+{
+}
+
+FakeScheduleDaemon::~FakeScheduleDaemon()
+{
+}
+
+bool FakeScheduleDaemon::isValid() const
+{
+    return m_writer != nullptr;
+}
+
+bool FakeScheduleDaemon::subscribe(KDarkLightScheduleSubscription *subscription)
+{
+    m_subscription = subscription;
+    return QMetaObject::invokeMethod(subscription, "OnSubscribed", Q_ARG(QVariantMap, QVariantMap({
+                                                                                 {QStringLiteral("Cookie"), 1u},
+                                                                                 {QStringLiteral("ScheduleFile"), m_fileName},
+                                                                             })));
+}
+
+quint64 FakeScheduleDaemon::publish(const KDarkLightSchedule &schedule)
+{
+    const quint64 generation = m_writer->publish(schedule);
+    if (m_subscription) {
+        QMetaObject::invokeMethod(m_subscription, "OnRefreshed", Q_ARG(QVariantMap, QVariantMap({
+                                                                          {QStringLiteral("Generation"), generation},
+                                                                      })));
+    }
+    return generation;
+}
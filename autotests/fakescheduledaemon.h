@@ -0,0 +1,38 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "kdarklightschedule.h"
+
+#include <QPointer>
+#include <QString>
+
+#include <memory>
+
+class KDarkLightScheduleFile;
+class KDarkLightScheduleSubscription;
+
+/*
+ * The FakeScheduleDaemon pretends that knighttimed has accepted a subscription, so the tests can
+ * publish new schedules through a shared schedule file without running the daemon.
+ */
+class FakeScheduleDaemon
+{
+public:
+    explicit FakeScheduleDaemon(const QString &fileName);
+    ~FakeScheduleDaemon();
+
+    bool isValid() const;
+
+    bool subscribe(KDarkLightScheduleSubscription *subscription);
+    quint64 publish(const KDarkLightSchedule &schedule);
+
+private:
+    QString m_fileName;
+    std::unique_ptr<KDarkLightScheduleFile> m_writer;
+    QPointer<KDarkLightScheduleSubscription> m_subscription;
+};
@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QProcess>
+#include <QTest>
+
+class FootprintBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void consumer_data();
+    void consumer();
+    void cleanupTestCase();
+
+private:
+    QHash<QString, qint64> m_residentMemory;
+};
+
+void FootprintBenchmark::initTestCase()
+{
+    QVERIFY(QFile::exists(QStringLiteral(FOOTPRINT_CORECONSUMER_EXECUTABLE)));
+    QVERIFY(QFile::exists(QStringLiteral(FOOTPRINT_QTCONSUMER_EXECUTABLE)));
+}
+
+void FootprintBenchmark::consumer_data()
+{
+    QTest::addColumn<QString>("executable");
+
+    QTest::addRow("core") << QStringLiteral(FOOTPRINT_CORECONSUMER_EXECUTABLE);
+    QTest::addRow("qt") << QStringLiteral(FOOTPRINT_QTCONSUMER_EXECUTABLE);
+}
+
+void FootprintBenchmark::consumer()
+{
+    QFETCH(QString, executable);
+
+    // The first run warms up the page cache, it is not counted.
+    const int runCount = 20;
+    qint64 totalTime = 0;
+    qint64 residentMemory = 0;
+
+    for (int i = 0; i <= runCount; ++i) {
+        QProcess process;
+        process.setProgram(executable);
+
+        QElapsedTimer timer;
+        timer.start();
+        process.start();
+        QVERIFY(process.waitForFinished());
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        QCOMPARE(process.exitStatus(), QProcess::NormalExit);
+        QCOMPARE(process.exitCode(), 0);
+
+        if (i > 0) {
+            totalTime += elapsed;
+            residentMemory = std::max(residentMemory, process.readAllStandardOutput().trimmed().toLongLong());
+        }
+    }
+
+    qInfo("%s consumer: %.2fms to start, compute a schedule and exit, %lld KiB resident",
+          QTest::currentDataTag(),
+          totalTime / 1000000.0 / runCount,
+          residentMemory);
+    m_residentMemory[QString::fromLatin1(QTest::currentDataTag())] = residentMemory;
+}
+
+void FootprintBenchmark::cleanupTestCase()
+{
+    const qint64 core = m_residentMemory.value(QStringLiteral("core"));
+    const qint64 qt = m_residentMemory.value(QStringLiteral("qt"));
+    if (core && qt) {
+        QVERIFY(core > 0);
+        QVERIFY(core < qt);
+    }
+}
+
+QTEST_GUILESS_MAIN(FootprintBenchmark)
+
+#include "footprint_benchmark.moc"
@@ -0,0 +1,49 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+
+#include "kdarklightschedule.h"
+
+#include <cstdio>
+
+/*
+ * The same work as in coreconsumer/footprint_coreconsumer.cpp, but done using the Qt types.
+ */
+
+static qint64 residentMemory()
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').constFirst().toLongLong();
+        }
+    }
+
+    return -1;
+}
+
+int main()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    const auto schedule = KDarkLightSchedule::forecast(now, 50.45, 30.52);
+    if (!schedule || !schedule->nextTransition(now)) {
+        return 1;
+    }
+
+    if (KDarkLightSchedule::fromState(schedule->toState()) != schedule) {
+        return 1;
+    }
+
+    std::printf("%lld\n", residentMemory());
+    return 0;
+}
@@ -0,0 +1,217 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "fakescheduledaemon.h"
+#include "kdarklightphasetracker.h"
+#include "kdarklightphasetracker_p.h"
+#include "kdarklightscheduleprovider.h"
+#include "kdarklightschedulesubscription_p.h"
+
+using namespace std::chrono_literals;
+
+class PhaseTrackerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void boundaries();
+    void skew();
+    void scheduleChanged();
+    void wakeups_data();
+    void wakeups();
+
+private:
+    void publish(const KDarkLightSchedule &schedule);
+
+    QTemporaryDir m_dir;
+    std::unique_ptr<FakeScheduleDaemon> m_daemon;
+    std::shared_ptr<KDarkLightScheduleSubscription> m_subscription;
+};
+
+void PhaseTrackerTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // Keep the schedule file away from the knighttimed instance that may be running in the session.
+    QVERIFY(m_dir.isValid());
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(m_dir.path()));
+
+    m_daemon = std::make_unique<FakeScheduleDaemon>(m_dir.filePath(QStringLiteral("schedule")));
+    QVERIFY(m_daemon->isValid());
+    m_daemon->publish(KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0))));
+
+    m_subscription = KDarkLightScheduleSubscription::globalSubscription();
+    QVERIFY(m_daemon->subscribe(m_subscription.get()));
+}
+
+void PhaseTrackerTest::publish(const KDarkLightSchedule &schedule)
+{
+    m_daemon->publish(schedule);
+}
+
+void PhaseTrackerTest::boundaries()
+{
+    const KDarkLightSchedule schedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0)), 50.45, 30.52).value();
+    publish(schedule);
+
+    const QList<KDarkLightCycle> cycles = schedule.cycles();
+    KNightTimeVirtualClock clock(cycles.first().noonDateTime());
+
+    KDarkLightScheduleProvider provider;
+    QCOMPARE(provider.schedule(), schedule);
+
+    KDarkLightPhaseTracker tracker(&provider);
+    KDarkLightPhaseTrackerPrivate::get(&tracker)->setClock(&clock);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Day);
+    QCOMPARE(tracker.progress(), 0.0);
+
+    QList<QPair<QDateTime, KDarkLightPhaseTracker::Phase>> phaseChanges;
+    connect(&tracker, &KDarkLightPhaseTracker::phaseChanged, this, [&]() {
+        phaseChanges.append(qMakePair(clock.currentDateTime(), tracker.phase()));
+    });
+
+    bool progressOutsideTransition = false;
+    connect(&tracker, &KDarkLightPhaseTracker::progressChanged, this, [&]() {
+        const QDateTime now = clock.currentDateTime();
+        const auto transition = provider.schedule().previousTransition(now);
+        if (tracker.progress() != 0.0 && (!transition || now < transition->startDateTime() || transition->endDateTime() < now)) {
+            progressOutsideTransition = true;
+        }
+    });
+
+    clock.advance(std::chrono::milliseconds(cycles.first().noonDateTime().msecsTo(cycles.last().noonDateTime())));
+
+    QList<QPair<QDateTime, KDarkLightPhaseTracker::Phase>> expectedPhaseChanges;
+    for (qsizetype i = 0; i < cycles.size(); ++i) {
+        const KDarkLightCycle &cycle = cycles[i];
+        if (i > 0) {
+            expectedPhaseChanges.append(qMakePair(cycle.morning().startDateTime(), KDarkLightPhaseTracker::Morning));
+            expectedPhaseChanges.append(qMakePair(cycle.morning().endDateTime(), KDarkLightPhaseTracker::Day));
+        }
+        if (i + 1 < cycles.size()) {
+            expectedPhaseChanges.append(qMakePair(cycle.evening().startDateTime(), KDarkLightPhaseTracker::Evening));
+            expectedPhaseChanges.append(qMakePair(cycle.evening().endDateTime(), KDarkLightPhaseTracker::Night));
+        }
+    }
+
+    QCOMPARE(phaseChanges, expectedPhaseChanges);
+    QVERIFY(!progressOutsideTransition);
+}
+
+void PhaseTrackerTest::skew()
+{
+    const KDarkLightSchedule schedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0)));
+    publish(schedule);
+
+    KNightTimeVirtualClock clock(QDateTime(QDate(2025, 5, 2), QTime(12, 0)));
+
+    KDarkLightScheduleProvider provider;
+    KDarkLightPhaseTracker tracker(&provider);
+    KDarkLightPhaseTrackerPrivate::get(&tracker)->setClock(&clock);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Day);
+
+    QSignalSpy phaseChangedSpy(&tracker, &KDarkLightPhaseTracker::phaseChanged);
+
+    // The time is changed manually, the phase must be updated right away.
+    clock.skew(-10h);
+    QCOMPARE(clock.currentDateTime(), QDateTime(QDate(2025, 5, 2), QTime(2, 0)));
+    QCOMPARE(phaseChangedSpy.count(), 1);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Night);
+
+    // The timer must be re-armed for the morning rather than the evening.
+    clock.advance(4h);
+    QCOMPARE(phaseChangedSpy.count(), 2);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Morning);
+    QCOMPARE(tracker.progress(), 0.0);
+
+    clock.advance(15min);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Morning);
+    QCOMPARE(tracker.progress(), 0.5);
+}
+
+void PhaseTrackerTest::scheduleChanged()
+{
+    publish(KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0))));
+
+    KNightTimeVirtualClock clock(QDateTime(QDate(2025, 5, 2), QTime(17, 0)));
+
+    KDarkLightScheduleProvider provider;
+    KDarkLightPhaseTracker tracker(&provider);
+    KDarkLightPhaseTrackerPrivate::get(&tracker)->setClock(&clock);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Day);
+
+    // The evening now starts earlier, the tracker must pick it up without waiting for the old one.
+    publish(KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0)), QTime(6, 0), QTime(16, 45)));
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Evening);
+    QCOMPARE(tracker.progress(), 0.5);
+
+    publish(KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0)), QTime(6, 0), QTime(17, 30)));
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Day);
+    QCOMPARE(tracker.progress(), 0.0);
+
+    QSignalSpy phaseChangedSpy(&tracker, &KDarkLightPhaseTracker::phaseChanged);
+    clock.advance(30min);
+    QCOMPARE(phaseChangedSpy.count(), 1);
+    QCOMPARE(tracker.phase(), KDarkLightPhaseTracker::Evening);
+}
+
+void PhaseTrackerTest::wakeups_data()
+{
+    QTest::addColumn<int>("progressInterval");
+
+    QTest::addRow("phase only") << 0;
+    QTest::addRow("10s") << 10000;
+    QTest::addRow("1min") << 60000;
+}
+
+void PhaseTrackerTest::wakeups()
+{
+    QFETCH(int, progressInterval);
+
+    const KDarkLightSchedule schedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1), QTime(12, 0)), 50.45, 30.52).value();
+    publish(schedule);
+
+    const QList<KDarkLightCycle> cycles = schedule.cycles();
+    KNightTimeVirtualClock clock(cycles.first().noonDateTime());
+
+    KDarkLightScheduleProvider provider;
+    KDarkLightPhaseTracker tracker(&provider);
+    tracker.setProgressInterval(std::chrono::milliseconds(progressInterval));
+    KDarkLightPhaseTrackerPrivate::get(&tracker)->setClock(&clock);
+
+    const auto duration = std::chrono::milliseconds(cycles.first().noonDateTime().msecsTo(cycles.last().noonDateTime()));
+    const qreal days = std::chrono::duration<qreal, std::ratio<86400>>(duration).count();
+
+    // A consumer that polls the schedule once a minute.
+    int pollerWakeups = 0;
+    auto poller = clock.createTimer();
+    connect(poller.get(), &KNightTimeTimer::timeout, this, [&]() {
+        ++pollerWakeups;
+        poller->start(1min);
+    });
+    poller->start(1min);
+
+    clock.advance(duration);
+
+    const quint64 trackerWakeups = KDarkLightPhaseTrackerPrivate::get(&tracker)->wakeups;
+    qInfo("%s: %.1f wakeups per day, a 1-minute poller wakes up %.1f times per day",
+          QTest::currentDataTag(),
+          trackerWakeups / days,
+          pollerWakeups / days);
+    QVERIFY(trackerWakeups < quint64(pollerWakeups));
+}
+
+QTEST_GUILESS_MAIN(PhaseTrackerTest)
+
+#include "phasetracker_test.moc"
@@ -0,0 +1,152 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTimeZone>
+
+#include "knighttimeclock_p.h"
+#include "kpositionupdatecontroller.h"
+#include "kreplaypositioninfosource.h"
+
+using namespace std::chrono_literals;
+
+class PositionUpdatesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void replay_data();
+    void replay();
+
+private:
+    QTemporaryDir m_dataDir;
+};
+
+static QByteArray nmeaAngle(qreal angle, int degreeDigits)
+{
+    const qreal absolute = std::abs(angle);
+    const int degrees = int(absolute);
+    const qreal minutes = (absolute - degrees) * 60;
+    return QByteArray::number(degrees).rightJustified(degreeDigits, '0') + QByteArray::number(minutes, 'f', 4).rightJustified(7, '0');
+}
+
+static QByteArray nmeaSentence(const QDateTime &dateTime, qreal latitude, qreal longitude)
+{
+    const QByteArray body = "GPRMC," + dateTime.toString(QStringLiteral("hhmmss.00")).toLatin1() + ",A," //
+        + nmeaAngle(latitude, 2) + (latitude < 0 ? ",S," : ",N,") //
+        + nmeaAngle(longitude, 3) + (longitude < 0 ? ",W," : ",E,") //
+        + "0.0,0.0," + dateTime.toString(QStringLiteral("ddMMyy")).toLatin1() + ",,,A";
+
+    quint8 checksum = 0;
+    for (const char c : body) {
+        checksum ^= quint8(c);
+    }
+
+    return '$' + body + '*' + QByteArray::number(checksum, 16).toUpper().rightJustified(2, '0') + '\n';
+}
+
+static std::chrono::seconds recordingDuration(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0s;
+    }
+
+    QDateTime first;
+    QDateTime last;
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().split(',');
+        if (fields.size() < 10) {
+            continue;
+        }
+
+        const QDate date = QDate::fromString(QString::fromLatin1(fields[9]), QStringLiteral("ddMMyy")).addYears(100);
+        const QTime time = QTime::fromString(QString::fromLatin1(fields[1].left(6)), QStringLiteral("hhmmss"));
+        last = QDateTime(date, time, QTimeZone::UTC);
+        if (!first.isValid()) {
+            first = last;
+        }
+    }
+
+    return std::chrono::seconds(first.secsTo(last));
+}
+
+void PositionUpdatesBenchmark::initTestCase()
+{
+    QVERIFY(m_dataDir.isValid());
+
+    // A desktop computer that reports a new fix every minute for a day, with some jitter.
+    QFile desk(m_dataDir.filePath(QStringLiteral("desk.nmea")));
+    QVERIFY(desk.open(QIODevice::WriteOnly));
+
+    const QDateTime start(QDate(2025, 5, 26), QTime(0, 0), QTimeZone::UTC);
+    for (int minute = 0; minute <= 24 * 60; ++minute) {
+        const qreal jitter = (minute % 7 - 3) * 0.0001;
+        desk.write(nmeaSentence(start.addSecs(minute * 60), 50.45 + jitter, 30.52 - jitter));
+    }
+}
+
+void PositionUpdatesBenchmark::replay_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<bool>("adaptive");
+
+    const QList<std::pair<const char *, QString>> recordings{
+        {"desk", m_dataDir.filePath(QStringLiteral("desk.nmea"))},
+        {"commute", QFINDTESTDATA("data/commute.nmea")},
+        {"flight", QFINDTESTDATA("data/flight.nmea")},
+    };
+
+    for (const auto &[name, fileName] : recordings) {
+        QTest::addRow("%s continuous", name) << fileName << false;
+        QTest::addRow("%s adaptive", name) << fileName << true;
+    }
+}
+
+void PositionUpdatesBenchmark::replay()
+{
+    QFETCH(QString, fileName);
+    QFETCH(bool, adaptive);
+
+    const std::chrono::seconds duration = recordingDuration(fileName);
+    QVERIFY(duration > 0s);
+
+    KNightTimeVirtualClock clock(QDateTime(QDate(2025, 5, 26), QTime(0, 0), QTimeZone::UTC));
+    KReplayPositionInfoSource source(fileName, 1, &clock);
+
+    int callbacks = 0;
+    connect(&source, &QGeoPositionInfoSource::positionUpdated, this, [&callbacks]() {
+        ++callbacks;
+    });
+
+    std::unique_ptr<KPositionUpdateController> controller;
+    if (adaptive) {
+        controller = std::make_unique<KPositionUpdateController>(&source, &clock);
+        controller->start();
+    } else {
+        source.startUpdates();
+    }
+
+    for (std::chrono::seconds elapsed = 0s; elapsed <= duration; elapsed += 1min) {
+        clock.advance(1min);
+    }
+
+    QVERIFY(callbacks > 0);
+    qInfo("%s: %d position callbacks in %llds, %.1f callbacks per day, stationary at the end: %s",
+          QTest::currentDataTag(),
+          callbacks,
+          qint64(duration.count()),
+          callbacks * 86400.0 / duration.count(),
+          controller && controller->isStationary() ? "yes" : "no");
+}
+
+QTEST_GUILESS_MAIN(PositionUpdatesBenchmark)
+
+#include "positionupdates_benchmark.moc"
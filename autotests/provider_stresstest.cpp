@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "fakescheduledaemon.h"
+#include "kdarklightscheduleprovider.h"
+#include "kdarklightschedulesubscription_p.h"
+
+#include <atomic>
+#include <thread>
+
+/*
+ * Reads provider snapshots from many threads while the schedule keeps changing. Build with
+ * -DECM_ENABLE_SANITIZERS=thread to check the snapshot API with ThreadSanitizer.
+ */
+class ProviderStressTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void snapshot();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+void ProviderStressTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+}
+
+void ProviderStressTest::snapshot()
+{
+    FakeScheduleDaemon daemon(m_dir.filePath(QStringLiteral("schedule")));
+    QVERIFY(daemon.isValid());
+
+    QList<KDarkLightSchedule> schedules;
+    for (int day = 0; day < 16; ++day) {
+        schedules.append(KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 1).addDays(day), QTime(12, 0)), 50.45, 30.52).value());
+    }
+    daemon.publish(schedules.first());
+
+    KDarkLightScheduleProvider provider;
+
+    const auto subscription = KDarkLightScheduleSubscription::globalSubscription();
+    QVERIFY(daemon.subscribe(subscription.get()));
+    QCOMPARE(*provider.snapshot(), schedules.first());
+
+    std::atomic<quint64> readCount = 0;
+    std::atomic<quint64> failureCount = 0;
+
+    // The readers are stopped and joined when the vector goes out of scope, also if a check below fails.
+    std::vector<std::jthread> readers;
+    const int readerCount = std::max(4, int(std::thread::hardware_concurrency()));
+    for (int i = 0; i < readerCount; ++i) {
+        readers.emplace_back([&](std::stop_token stopToken) {
+            while (!stopToken.stop_requested()) {
+                const std::shared_ptr<const KDarkLightSchedule> snapshot = provider.snapshot();
+                if (!snapshot || !schedules.contains(*snapshot)) {
+                    failureCount++;
+                }
+                readCount++;
+            }
+        });
+    }
+
+    for (int i = 1; i <= 2000; ++i) {
+        daemon.publish(schedules.at(i % schedules.size()));
+        QCOMPARE(provider.schedule(), schedules.at(i % schedules.size()));
+    }
+
+    readers.clear();
+
+    qInfo("%d readers took %llu snapshots while the schedule changed 2000 times", readerCount, quint64(readCount));
+    QCOMPARE(failureCount.load(), quint64(0));
+}
+
+QTEST_GUILESS_MAIN(ProviderStressTest)
+
+#include "provider_stresstest.moc"
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "kdarklightschedulefile_p.h"
+#include "kdarklightscheduleprovider.h"
+
+class ProviderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cachedSchedule();
+    void staleCacheLosesToState();
+    void olderCacheLosesToState();
+
+private:
+    QTemporaryDir m_runtimeDir;
+};
+
+void ProviderTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // Make sure that the schedule file of a running daemon is not picked up.
+    QVERIFY(m_runtimeDir.isValid());
+    qputenv("XDG_RUNTIME_DIR", QFile::encodeName(m_runtimeDir.path()));
+}
+
+void ProviderTest::init()
+{
+    QFile::remove(KDarkLightScheduleFile::cacheFileName());
+}
+
+static KDarkLightSchedule forecast(const QDateTime &dateTime)
+{
+    return KDarkLightSchedule::forecast(dateTime, 50.45, 30.52).value();
+}
+
+void ProviderTest::cachedSchedule()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const KDarkLightSchedule cached = forecast(now);
+    QVERIFY(KDarkLightScheduleFile::save(KDarkLightScheduleFile::cacheFileName(), cached));
+
+    // A new provider starts with the cached schedule rather than the default one, even if the
+    // application has saved an older state.
+    {
+        KDarkLightScheduleProvider provider;
+        QCOMPARE(provider.schedule(), cached);
+    }
+    {
+        KDarkLightScheduleProvider provider(forecast(now.addDays(-1)).toState());
+        QCOMPARE(provider.schedule(), cached);
+    }
+}
+
+void ProviderTest::staleCacheLosesToState()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    QVERIFY(KDarkLightScheduleFile::save(KDarkLightScheduleFile::cacheFileName(), forecast(now.addDays(-30))));
+
+    const KDarkLightSchedule saved = forecast(now);
+    KDarkLightScheduleProvider provider(saved.toState());
+    QCOMPARE(provider.schedule(), saved);
+}
+
+void ProviderTest::olderCacheLosesToState()
+{
+    // The cached schedule still covers the current time, but the application has a newer one.
+    const QDateTime now = QDateTime::currentDateTime();
+    QVERIFY(KDarkLightScheduleFile::save(KDarkLightScheduleFile::cacheFileName(), forecast(now.addDays(-1))));
+
+    const KDarkLightSchedule saved = forecast(now);
+    KDarkLightScheduleProvider provider(saved.toState());
+    QCOMPARE(provider.schedule(), saved);
+}
+
+QTEST_GUILESS_MAIN(ProviderTest)
+
+#include "provider_test.moc"
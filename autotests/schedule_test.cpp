@@ -79,10 +79,10 @@ void ScheduleTest::solarForecast()
     const QList<KDarkLightCycle> cycles{
         KDarkLightCycle(QDateTime(QDate(2025, 5, 24), QTime(12, 54, 48), tz),
                         KDarkLightTransition(KDarkLightTransition::Morning, QDateTime(QDate(2025, 5, 24), QTime(4, 16, 33), tz), QDateTime(QDate(2025, 5, 24), QTime(4, 58, 34), tz)),
-                        KDarkLightTransition(KDarkLightTransition::Evening, QDateTime(QDate(2025, 5, 24), QTime(20, 51, 1), tz), QDateTime(QDate(2025, 5, 24), QTime(21, 33, 3), tz))),
+                        KDarkLightTransition(KDarkLightTransition::Evening, QDateTime(QDate(2025, 5, 24), QTime(20, 51, 2), tz), QDateTime(QDate(2025, 5, 24), QTime(21, 33, 3), tz))),
         KDarkLightCycle(QDateTime(QDate(2025, 5, 25), QTime(12, 54, 54), tz),
                         KDarkLightTransition(KDarkLightTransition::Morning, QDateTime(QDate(2025, 5, 25), QTime(4, 15, 17), tz), QDateTime(QDate(2025, 5, 25), QTime(4, 57, 31), tz)),
-                        KDarkLightTransition(KDarkLightTransition::Evening, QDateTime(QDate(2025, 5, 25), QTime(20, 52, 16), tz), QDateTime(QDate(2025, 5, 25), QTime(21, 34, 30), tz))),
+                        KDarkLightTransition(KDarkLightTransition::Evening, QDateTime(QDate(2025, 5, 25), QTime(20, 52, 17), tz), QDateTime(QDate(2025, 5, 25), QTime(21, 34, 30), tz))),
         KDarkLightCycle(QDateTime(QDate(2025, 5, 26), QTime(12, 55, 0), tz),
                         KDarkLightTransition(KDarkLightTransition::Morning, QDateTime(QDate(2025, 5, 26), QTime(4, 14, 4), tz), QDateTime(QDate(2025, 5, 26), QTime(4, 56, 30), tz)),
                         KDarkLightTransition(KDarkLightTransition::Evening, QDateTime(QDate(2025, 5, 26), QTime(20, 53, 30), tz), QDateTime(QDate(2025, 5, 26), QTime(21, 35, 56), tz))),
@@ -0,0 +1,225 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTimeZone>
+
+#include "kdarklightschedulecache.h"
+
+class ScheduleCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void geohash();
+    void forecast();
+    void persistent();
+    void version();
+    void eviction();
+    void polarDay();
+    void cellCorners_data();
+    void cellCorners();
+
+private:
+    QString fileName() const;
+
+    std::unique_ptr<QTemporaryDir> m_cacheDir;
+};
+
+static const QTimeZone kyivTimeZone(QByteArrayLiteral("Europe/Kyiv"));
+static const QGeoCoordinate kyiv(50.45, 30.52);
+
+static std::optional<KDarkLightSchedule> forecastForCell(const QDateTime &dateTime, const QGeoCoordinate &coordinate)
+{
+    const QGeoCoordinate center = KDarkLightScheduleCache::geohashBounds(KDarkLightScheduleCache::cell(coordinate)).center();
+    return KDarkLightSchedule::forecast(dateTime, center.latitude(), center.longitude());
+}
+
+static qint64 maxTransitionShift(const KDarkLightSchedule &a, const KDarkLightSchedule &b)
+{
+    const QList<KDarkLightCycle> aCycles = a.cycles();
+    const QList<KDarkLightCycle> bCycles = b.cycles();
+    Q_ASSERT(aCycles.size() == bCycles.size());
+
+    qint64 shift = 0;
+    for (qsizetype i = 0; i < aCycles.size(); ++i) {
+        shift = std::max({
+            shift,
+            std::abs(aCycles[i].morning().startDateTime().secsTo(bCycles[i].morning().startDateTime())),
+            std::abs(aCycles[i].morning().endDateTime().secsTo(bCycles[i].morning().endDateTime())),
+            std::abs(aCycles[i].evening().startDateTime().secsTo(bCycles[i].evening().startDateTime())),
+            std::abs(aCycles[i].evening().endDateTime().secsTo(bCycles[i].evening().endDateTime())),
+        });
+    }
+    return shift;
+}
+
+void ScheduleCacheTest::init()
+{
+    m_cacheDir = std::make_unique<QTemporaryDir>();
+    QVERIFY(m_cacheDir->isValid());
+}
+
+QString ScheduleCacheTest::fileName() const
+{
+    return m_cacheDir->filePath(QStringLiteral("schedules"));
+}
+
+void ScheduleCacheTest::geohash()
+{
+    QCOMPARE(KDarkLightScheduleCache::geohash(QGeoCoordinate(57.64911, 10.40744), 11), QByteArrayLiteral("u4pruydqqvj"));
+    QCOMPARE(KDarkLightScheduleCache::geohash(kyiv, 5), QByteArrayLiteral("u8vxn"));
+    QCOMPARE(KDarkLightScheduleCache::geohash(QGeoCoordinate(-0.18, -78.47), 5), QByteArrayLiteral("6rbny"));
+
+    const QGeoRectangle bounds = KDarkLightScheduleCache::geohashBounds(QByteArrayLiteral("u8vxn"));
+    QVERIFY(bounds.contains(kyiv));
+    QVERIFY(bounds.width() < 0.05);
+    QVERIFY(bounds.height() < 0.05);
+    QCOMPARE(KDarkLightScheduleCache::geohash(bounds.center(), 5), QByteArrayLiteral("u8vxn"));
+}
+
+void ScheduleCacheTest::forecast()
+{
+    KDarkLightScheduleCache cache(fileName());
+
+    const QDateTime dateTime(QDate(2025, 3, 20), QTime(10, 0), kyivTimeZone);
+    QCOMPARE(cache.forecast(dateTime, kyiv), forecastForCell(dateTime, kyiv));
+    QCOMPARE(cache.hits(), quint64(0));
+    QCOMPARE(cache.misses(), quint64(1));
+
+    // The next days are served from the same entry.
+    for (int day = 0; day < 14; ++day) {
+        const QDateTime nextDateTime = dateTime.addDays(day);
+        QCOMPARE(cache.forecast(nextDateTime, kyiv), forecastForCell(nextDateTime, kyiv));
+    }
+    QCOMPARE(cache.hits(), quint64(14));
+    QCOMPARE(cache.misses(), quint64(1));
+
+    // A place a few hundred meters away is in the same cell.
+    QVERIFY(cache.forecast(dateTime, QGeoCoordinate(50.452, 30.523)));
+    QCOMPARE(cache.hits(), quint64(15));
+
+    // The day before the first cached day is not in the cache.
+    QVERIFY(cache.forecast(dateTime.addDays(-1), kyiv));
+    QCOMPARE(cache.misses(), quint64(2));
+}
+
+void ScheduleCacheTest::persistent()
+{
+    const QDateTime dateTime(QDate(2025, 3, 20), QTime(10, 0), kyivTimeZone);
+
+    {
+        KDarkLightScheduleCache cache(fileName());
+        QVERIFY(cache.forecast(dateTime, kyiv));
+        QCOMPARE(cache.misses(), quint64(1));
+    }
+
+    KDarkLightScheduleCache cache(fileName());
+    QCOMPARE(cache.forecast(dateTime, kyiv), forecastForCell(dateTime, kyiv));
+    QCOMPARE(cache.hits(), quint64(1));
+    QCOMPARE(cache.misses(), quint64(0));
+}
+
+void ScheduleCacheTest::version()
+{
+    const QDateTime dateTime(QDate(2025, 3, 20), QTime(10, 0), kyivTimeZone);
+
+    {
+        KDarkLightScheduleCache cache(fileName());
+        QVERIFY(cache.forecast(dateTime, kyiv));
+    }
+
+    // Bump the version field that follows the magic number.
+    QFile file(fileName());
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(7));
+    QVERIFY(file.putChar(3));
+    file.close();
+
+    KDarkLightScheduleCache cache(fileName());
+    QVERIFY(cache.forecast(dateTime, kyiv));
+    QCOMPARE(cache.hits(), quint64(0));
+    QCOMPARE(cache.misses(), quint64(1));
+}
+
+void ScheduleCacheTest::eviction()
+{
+    const QDateTime dateTime(QDate(2025, 3, 20), QTime(10, 0), kyivTimeZone);
+
+    KDarkLightScheduleCache cache(fileName());
+    for (int i = 0; i < 33; ++i) {
+        QVERIFY(cache.forecast(dateTime, QGeoCoordinate(kyiv.latitude() + i * 0.1, kyiv.longitude())));
+
+        // Keep the first place in use.
+        QVERIFY(cache.forecast(dateTime, kyiv));
+    }
+    QCOMPARE(cache.misses(), quint64(33));
+
+    // The second place is the least recently used one.
+    KDarkLightScheduleCache reloaded(fileName());
+    QVERIFY(reloaded.forecast(dateTime, kyiv));
+    QVERIFY(reloaded.forecast(dateTime, QGeoCoordinate(kyiv.latitude() + 3.2, kyiv.longitude())));
+    QCOMPARE(reloaded.hits(), quint64(2));
+    QVERIFY(reloaded.forecast(dateTime, QGeoCoordinate(kyiv.latitude() + 0.1, kyiv.longitude())));
+    QCOMPARE(reloaded.misses(), quint64(1));
+}
+
+void ScheduleCacheTest::polarDay()
+{
+    KDarkLightScheduleCache cache(fileName());
+
+    const QDateTime dateTime(QDate(2025, 6, 21), QTime(10, 0), QTimeZone(QByteArrayLiteral("Europe/Oslo")));
+    const QGeoCoordinate tromso(69.65, 18.96);
+    QCOMPARE(cache.forecast(dateTime, tromso), std::nullopt);
+    QCOMPARE(cache.forecast(dateTime, tromso), std::nullopt);
+    QCOMPARE(cache.misses(), quint64(2));
+}
+
+void ScheduleCacheTest::cellCorners_data()
+{
+    QTest::addColumn<QDateTime>("dateTime");
+    QTest::addColumn<QGeoCoordinate>("coordinate");
+
+    QTest::addRow("kyiv") << QDateTime(QDate(2025, 6, 21), QTime(10, 0), kyivTimeZone) << kyiv;
+    QTest::addRow("oslo") << QDateTime(QDate(2025, 6, 21), QTime(10, 0), QTimeZone(QByteArrayLiteral("Europe/Oslo"))) << QGeoCoordinate(59.91, 10.75);
+    QTest::addRow("helsinki") << QDateTime(QDate(2025, 6, 10), QTime(10, 0), QTimeZone(QByteArrayLiteral("Europe/Helsinki"))) << QGeoCoordinate(60.17, 24.94);
+    QTest::addRow("oulu") << QDateTime(QDate(2025, 5, 10), QTime(10, 0), QTimeZone(QByteArrayLiteral("Europe/Helsinki"))) << QGeoCoordinate(65.01, 25.47);
+    QTest::addRow("reykjavik") << QDateTime(QDate(2025, 12, 21), QTime(10, 0), QTimeZone(QByteArrayLiteral("Atlantic/Reykjavik"))) << QGeoCoordinate(64.13, -21.9);
+}
+
+void ScheduleCacheTest::cellCorners()
+{
+    QFETCH(QDateTime, dateTime);
+    QFETCH(QGeoCoordinate, coordinate);
+
+    KDarkLightScheduleCache cache(fileName());
+
+    // Opposite corners of the same cell, where the transitions differ the most from those in the middle.
+    const QGeoRectangle bounds = KDarkLightScheduleCache::geohashBounds(KDarkLightScheduleCache::cell(coordinate));
+    const qreal epsilon = 1e-9;
+    const QGeoCoordinate topLeft(bounds.topLeft().latitude() - epsilon, bounds.topLeft().longitude() + epsilon);
+    const QGeoCoordinate bottomRight(bounds.bottomRight().latitude() + epsilon, bounds.bottomRight().longitude() - epsilon);
+    QCOMPARE(KDarkLightScheduleCache::cell(topLeft), KDarkLightScheduleCache::cell(coordinate));
+    QCOMPARE(KDarkLightScheduleCache::cell(bottomRight), KDarkLightScheduleCache::cell(coordinate));
+
+    for (const QGeoCoordinate &corner : {topLeft, bottomRight}) {
+        const auto cached = cache.forecast(dateTime, corner);
+        const auto expected = KDarkLightSchedule::forecast(dateTime, corner.latitude(), corner.longitude());
+        QVERIFY(cached);
+        QVERIFY(expected);
+
+        const qint64 shift = maxTransitionShift(*cached, *expected);
+        QVERIFY2(shift < 60, qPrintable(QStringLiteral("%1 s off at %2").arg(shift).arg(corner.toString())));
+    }
+}
+
+QTEST_GUILESS_MAIN(ScheduleCacheTest)
+
+#include "schedulecache_test.moc"
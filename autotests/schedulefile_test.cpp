@@ -0,0 +1,199 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+#include "kdarklightdbustypes_p.h"
+#include "kdarklightschedule.h"
+#include "kdarklightschedulefile_p.h"
+
+class ScheduleServer : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.NightTime.Test")
+
+public:
+    explicit ScheduleServer(const KDarkLightSchedule &schedule)
+        : m_schedule(schedule)
+    {
+    }
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QVariantMap Refresh()
+    {
+        return QVariantMap{
+            {QStringLiteral("Schedule"), QVariant::fromValue(KNightTimeDbusSchedule::from(m_schedule))},
+        };
+    }
+
+private:
+    KDarkLightSchedule m_schedule;
+};
+
+class ScheduleFileTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void publish();
+    void reopen();
+    void save();
+    void invalid();
+    void benchmarkFileRefresh();
+    void benchmarkDbusRefresh();
+
+private:
+    QTemporaryDir m_dir;
+    KDarkLightSchedule m_schedule;
+};
+
+void ScheduleFileTest::initTestCase()
+{
+    qDBusRegisterMetaType<KNightTimeDbusCycle>();
+    qDBusRegisterMetaType<QList<KNightTimeDbusCycle>>();
+    qDBusRegisterMetaType<KNightTimeDbusSchedule>();
+
+    QVERIFY(m_dir.isValid());
+    m_schedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 25), QTime(12, 0)), 50.45, 30.52).value();
+}
+
+void ScheduleFileTest::publish()
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("publish"));
+
+    const auto writer = KDarkLightScheduleFile::create(fileName);
+    QVERIFY(writer);
+
+    const auto reader = KDarkLightScheduleFile::open(fileName);
+    QVERIFY(reader);
+    QCOMPARE(reader->generation(), quint64(0));
+    QCOMPARE(reader->read(), std::nullopt);
+
+    QCOMPARE(writer->publish(m_schedule), quint64(1));
+    QCOMPARE(reader->generation(), quint64(1));
+    QCOMPARE(reader->read(), std::make_pair(quint64(1), m_schedule));
+
+    const KDarkLightSchedule otherSchedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 25), QTime(12, 0)));
+    QCOMPARE(writer->publish(otherSchedule), quint64(2));
+    QCOMPARE(reader->read(), std::make_pair(quint64(2), otherSchedule));
+}
+
+void ScheduleFileTest::reopen()
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("reopen"));
+
+    {
+        const auto writer = KDarkLightScheduleFile::create(fileName);
+        QVERIFY(writer);
+        QCOMPARE(writer->publish(m_schedule), quint64(1));
+    }
+
+    const auto reader = KDarkLightScheduleFile::open(fileName);
+    QVERIFY(reader);
+    QCOMPARE(reader->read(), std::make_pair(quint64(1), m_schedule));
+
+    // A restarted daemon continues the generation sequence, so clients notice the new schedule.
+    const auto writer = KDarkLightScheduleFile::create(fileName);
+    QVERIFY(writer);
+    QCOMPARE(writer->publish(m_schedule), quint64(2));
+    QCOMPARE(reader->generation(), quint64(2));
+}
+
+void ScheduleFileTest::save()
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("cache/schedule"));
+    QVERIFY(KDarkLightScheduleFile::save(fileName, m_schedule));
+
+    const auto reader = KDarkLightScheduleFile::open(fileName);
+    QVERIFY(reader);
+    QCOMPARE(reader->read(), std::make_pair(quint64(1), m_schedule));
+
+    // The file is replaced, so the existing mapping still sees the previous schedule.
+    const KDarkLightSchedule otherSchedule = KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 25), QTime(12, 0)));
+    QVERIFY(KDarkLightScheduleFile::save(fileName, otherSchedule));
+    QCOMPARE(reader->read(), std::make_pair(quint64(1), m_schedule));
+
+    const auto otherReader = KDarkLightScheduleFile::open(fileName);
+    QVERIFY(otherReader);
+    QCOMPARE(otherReader->read(), std::make_pair(quint64(1), otherSchedule));
+}
+
+void ScheduleFileTest::invalid()
+{
+    QVERIFY(!KDarkLightScheduleFile::open(m_dir.filePath(QStringLiteral("nonexistent"))));
+
+    const QString fileName = m_dir.filePath(QStringLiteral("invalid"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(4096, 'x'));
+    file.close();
+
+    QVERIFY(!KDarkLightScheduleFile::open(fileName));
+}
+
+void ScheduleFileTest::benchmarkFileRefresh()
+{
+    const QString fileName = m_dir.filePath(QStringLiteral("benchmark"));
+
+    const auto writer = KDarkLightScheduleFile::create(fileName);
+    QVERIFY(writer);
+    writer->publish(m_schedule);
+
+    const auto reader = KDarkLightScheduleFile::open(fileName);
+    QVERIFY(reader);
+
+    QBENCHMARK {
+        const auto snapshot = reader->read();
+        QCOMPARE(snapshot->second, m_schedule);
+    }
+}
+
+void ScheduleFileTest::benchmarkDbusRefresh()
+{
+    auto serverConnection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("server"));
+    auto clientConnection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("client"));
+    if (!serverConnection.isConnected() || !clientConnection.isConnected()) {
+        QSKIP("The session bus is not available");
+    }
+
+    // The server lives in its own thread so the client can make blocking calls.
+    QThread serverThread;
+    serverThread.start();
+
+    auto server = new ScheduleServer(m_schedule);
+    server->moveToThread(&serverThread);
+    serverConnection.registerObject(QStringLiteral("/Schedule"), server, QDBusConnection::ExportScriptableContents);
+
+    const auto message = QDBusMessage::createMethodCall(serverConnection.baseService(), QStringLiteral("/Schedule"), QStringLiteral("org.kde.NightTime.Test"), QStringLiteral("Refresh"));
+
+    QBENCHMARK {
+        const QDBusMessage reply = clientConnection.call(message);
+        QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+
+        const QVariantMap data = qdbus_cast<QVariantMap>(reply.arguments().constFirst());
+        const auto dbusSchedule = qdbus_cast<KNightTimeDbusSchedule>(data[QStringLiteral("Schedule")].value<QDBusArgument>());
+        QCOMPARE(dbusSchedule.into(), m_schedule);
+    }
+
+    serverConnection.unregisterObject(QStringLiteral("/Schedule"));
+    QMetaObject::invokeMethod(server, &QObject::deleteLater);
+    serverThread.quit();
+    serverThread.wait();
+
+    QDBusConnection::disconnectFromBus(QStringLiteral("server"));
+    QDBusConnection::disconnectFromBus(QStringLiteral("client"));
+}
+
+QTEST_MAIN(ScheduleFileTest)
+
+#include "schedulefile_test.moc"
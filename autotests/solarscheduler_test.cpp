@@ -0,0 +1,112 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QObject>
+#include <QTest>
+
+#include "ksolardarklightscheduler.h"
+
+using namespace std::chrono_literals;
+
+class SolarSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void estimateTransitionShift_data();
+    void estimateTransitionShift();
+    void estimateTransitionShiftPolarDay();
+    void estimateTransitionShiftPolarNight();
+    void estimateTransitionShiftPolarEdge();
+};
+
+static std::chrono::seconds transitionShift(const KDarkLightCycle &a, const KDarkLightCycle &b)
+{
+    const qint64 shift = std::max({
+        std::abs(a.morning().startDateTime().secsTo(b.morning().startDateTime())),
+        std::abs(a.morning().endDateTime().secsTo(b.morning().endDateTime())),
+        std::abs(a.evening().startDateTime().secsTo(b.evening().startDateTime())),
+        std::abs(a.evening().endDateTime().secsTo(b.evening().endDateTime())),
+    });
+    return std::chrono::seconds(shift);
+}
+
+void SolarSchedulerTest::estimateTransitionShift_data()
+{
+    QTest::addColumn<QDate>("date");
+    QTest::addColumn<QGeoCoordinate>("from");
+    QTest::addColumn<QGeoCoordinate>("to");
+
+    const QDate equinox(2025, 3, 20);
+    const QDate solstice(2025, 6, 21);
+
+    QTest::addRow("quito east") << equinox << QGeoCoordinate(-0.18, -78.47) << QGeoCoordinate(-0.18, -78.02);
+    QTest::addRow("quito north") << equinox << QGeoCoordinate(-0.18, -78.47) << QGeoCoordinate(0.27, -78.47);
+    QTest::addRow("kyiv east") << solstice << QGeoCoordinate(50.45, 30.52) << QGeoCoordinate(50.45, 31.22);
+    QTest::addRow("kyiv north") << solstice << QGeoCoordinate(50.45, 30.52) << QGeoCoordinate(50.9, 30.52);
+    QTest::addRow("kyiv north-east") << solstice << QGeoCoordinate(50.45, 30.52) << QGeoCoordinate(50.75, 30.82);
+    QTest::addRow("oslo north") << solstice << QGeoCoordinate(59.91, 10.75) << QGeoCoordinate(60.36, 10.75);
+    QTest::addRow("oslo south-west") << equinox << QGeoCoordinate(59.91, 10.75) << QGeoCoordinate(59.61, 10.45);
+}
+
+void SolarSchedulerTest::estimateTransitionShift()
+{
+    QFETCH(QDate, date);
+    QFETCH(QGeoCoordinate, from);
+    QFETCH(QGeoCoordinate, to);
+
+    const QDateTime referenceDateTime(date, QTime(12, 0));
+
+    KSolarDarkLightScheduler fromScheduler(from);
+    KSolarDarkLightScheduler toScheduler(to);
+
+    // The first cycle in the schedule is for the day before the reference date.
+    const KDarkLightCycle fromCycle = fromScheduler.schedule(referenceDateTime).cycles().at(1);
+    const KDarkLightCycle toCycle = toScheduler.schedule(referenceDateTime).cycles().at(1);
+
+    const std::chrono::seconds actual = transitionShift(fromCycle, toCycle);
+    const std::optional<std::chrono::seconds> estimate = fromScheduler.estimateTransitionShift(to, referenceDateTime);
+    QVERIFY(estimate.has_value());
+
+    const std::chrono::seconds estimated = *estimate;
+    QVERIFY2(std::abs((estimated - actual).count()) <= 10 + actual.count() / 5,
+             qPrintable(QStringLiteral("estimated %1s, actual %2s").arg(estimated.count()).arg(actual.count())));
+}
+
+void SolarSchedulerTest::estimateTransitionShiftPolarDay()
+{
+    const QDateTime referenceDateTime(QDate(2025, 6, 21), QTime(12, 0));
+
+    // The sun does not set in either place, so only the longitude matters.
+    KSolarDarkLightScheduler scheduler(QGeoCoordinate(69.65, 18.96));
+    const std::optional<std::chrono::seconds> shift = scheduler.estimateTransitionShift(QGeoCoordinate(69.75, 18.97), referenceDateTime);
+    QVERIFY(shift.has_value());
+    QCOMPARE(*shift, 2s);
+}
+
+void SolarSchedulerTest::estimateTransitionShiftPolarNight()
+{
+    const QDateTime referenceDateTime(QDate(2025, 12, 21), QTime(12, 0));
+
+    // The sun does not rise in either place, but the civil twilight still begins and ends.
+    KSolarDarkLightScheduler scheduler(QGeoCoordinate(69.65, 18.96));
+    const std::optional<std::chrono::seconds> shift = scheduler.estimateTransitionShift(QGeoCoordinate(69.66, 18.96), referenceDateTime);
+    QVERIFY(shift.has_value());
+    QVERIFY(*shift < 60s);
+}
+
+void SolarSchedulerTest::estimateTransitionShiftPolarEdge()
+{
+    const QDateTime referenceDateTime(QDate(2025, 6, 21), QTime(12, 0));
+
+    // The sun sets in Trondheim, but not in Tromsø.
+    KSolarDarkLightScheduler scheduler(QGeoCoordinate(69.65, 18.96));
+    QVERIFY(!scheduler.estimateTransitionShift(QGeoCoordinate(63.43, 10.39), referenceDateTime).has_value());
+}
+
+QTEST_GUILESS_MAIN(SolarSchedulerTest)
+
+#include "solarscheduler_test.moc"
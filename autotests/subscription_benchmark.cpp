@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include <QObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "fakescheduledaemon.h"
+#include "kdarklightschedulesubscription_p.h"
+
+class SubscriptionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void refresh_data();
+    void refresh();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+void SubscriptionBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+}
+
+void SubscriptionBenchmark::refresh_data()
+{
+    QTest::addColumn<bool>("readState");
+
+    QTest::addRow("without state reader") << false;
+    QTest::addRow("with state reader") << true;
+}
+
+void SubscriptionBenchmark::refresh()
+{
+    QFETCH(bool, readState);
+
+    FakeScheduleDaemon daemon(m_dir.filePath(QString::fromLatin1(QTest::currentDataTag())));
+    QVERIFY(daemon.isValid());
+
+    const KDarkLightSchedule schedules[] = {
+        KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 25), QTime(12, 0)), 50.45, 30.52).value(),
+        KDarkLightSchedule::forecast(QDateTime(QDate(2025, 5, 25), QTime(12, 0))),
+    };
+    daemon.publish(schedules[0]);
+
+    // The refresh path is the same as in applications that receive the shared schedule.
+    KDarkLightScheduleSubscription subscription;
+    QVERIFY(daemon.subscribe(&subscription));
+    QCOMPARE(subscription.schedule(), std::optional(schedules[0]));
+
+    int refreshCount = 0;
+    connect(&subscription, &KDarkLightScheduleSubscription::refreshed, this, [&refreshCount]() {
+        ++refreshCount;
+    });
+
+    int index = 0;
+    QBENCHMARK {
+        index = 1 - index;
+        daemon.publish(schedules[index]);
+        if (readState) {
+            QVERIFY(!subscription.state().isEmpty());
+        }
+    }
+
+    QVERIFY(refreshCount > 0);
+    QCOMPARE(subscription.schedule(), std::optional(schedules[index]));
+}
+
+QTEST_GUILESS_MAIN(SubscriptionBenchmark)
+
+#include "subscription_benchmark.moc"
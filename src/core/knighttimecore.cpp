@@ -0,0 +1,309 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knighttimecore.h"
+
+#include <cmath>
+#include <ctime>
+#include <numbers>
+
+using namespace std::chrono_literals;
+
+namespace KNightTimeCore
+{
+
+static std::tm toLocalTime(TimePoint time)
+{
+    const std::time_t seconds = std::chrono::floor<std::chrono::seconds>(time).time_since_epoch().count();
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    return local;
+}
+
+static TimePoint fromLocalTime(std::tm local)
+{
+    local.tm_isdst = -1;
+    return TimePoint(std::chrono::seconds(std::mktime(&local)));
+}
+
+static TimePoint addDays(TimePoint time, int days)
+{
+    const auto fraction = time - std::chrono::floor<std::chrono::seconds>(time);
+
+    std::tm local = toLocalTime(time);
+    local.tm_mday += days;
+    return fromLocalTime(local) + fraction;
+}
+
+Cycle Cycle::extrapolated(TimePoint reference) const
+{
+    const std::tm localReference = toLocalTime(reference);
+
+    std::tm localNoon = toLocalTime(noon);
+    localNoon.tm_year = localReference.tm_year;
+    localNoon.tm_mon = localReference.tm_mon;
+    localNoon.tm_mday = localReference.tm_mday;
+
+    const TimePoint newNoon = fromLocalTime(localNoon) + (noon - std::chrono::floor<std::chrono::seconds>(noon));
+    return Cycle{
+        .noon = newNoon,
+        .morning = Transition{
+            .type = Transition::Morning,
+            .start = newNoon - (noon - morning.start),
+            .end = newNoon - (noon - morning.end),
+        },
+        .evening = Transition{
+            .type = Transition::Evening,
+            .start = newNoon - (noon - evening.start),
+            .end = newNoon - (noon - evening.end),
+        },
+    };
+}
+
+static std::pair<int, std::chrono::milliseconds> closestCycle(const std::vector<Cycle> &cycles, TimePoint time)
+{
+    int bestIndex = -1;
+    std::chrono::milliseconds bestScore{};
+
+    for (size_t i = 0; i < cycles.size(); ++i) {
+        const auto score = std::chrono::abs(cycles[i].noon - time);
+        if (bestIndex == -1 || score < bestScore) {
+            bestIndex = i;
+            bestScore = score;
+        }
+    }
+
+    return std::make_pair(bestIndex, bestScore);
+}
+
+std::optional<Transition> Schedule::previousTransition(TimePoint reference) const
+{
+    const auto [index, diff] = closestCycle(cycles, reference);
+    if (index == -1) {
+        return std::nullopt;
+    }
+
+    const auto &cycle = cycles[index];
+    if (diff <= 12h) {
+        if (const auto transition = cycle.previousTransition(reference)) {
+            return transition;
+        }
+
+        if (index > 0) {
+            if (const auto transition = cycles[index - 1].previousTransition(reference)) {
+                return transition;
+            }
+        }
+    }
+
+    const auto extrapolatedCycle = cycle.extrapolated(reference);
+    if (const auto transition = extrapolatedCycle.previousTransition(reference)) {
+        return transition;
+    }
+
+    const auto &extrapolatedEvening = extrapolatedCycle.evening;
+    return Transition{
+        .type = extrapolatedEvening.type,
+        .start = addDays(extrapolatedEvening.start, -1),
+        .end = addDays(extrapolatedEvening.end, -1),
+    };
+}
+
+std::optional<Transition> Schedule::nextTransition(TimePoint reference) const
+{
+    const auto [index, diff] = closestCycle(cycles, reference);
+    if (index == -1) {
+        return std::nullopt;
+    }
+
+    const auto &cycle = cycles[index];
+    if (diff <= 12h) {
+        if (const auto transition = cycle.nextTransition(reference)) {
+            return transition;
+        }
+
+        if (size_t(index + 1) < cycles.size()) {
+            if (const auto transition = cycles[index + 1].nextTransition(reference)) {
+                return transition;
+            }
+        }
+    }
+
+    const auto extrapolatedCycle = cycle.extrapolated(reference);
+    if (const auto transition = extrapolatedCycle.nextTransition(reference)) {
+        return transition;
+    }
+
+    const auto &extrapolatedMorning = extrapolatedCycle.morning;
+    return Transition{
+        .type = extrapolatedMorning.type,
+        .start = addDays(extrapolatedMorning.start, 1),
+        .end = addDays(extrapolatedMorning.end, 1),
+    };
+}
+
+static std::chrono::seconds daylightDuration(std::chrono::seconds morning, std::chrono::seconds evening)
+{
+    if (morning < evening) {
+        return evening - morning;
+    } else {
+        return std::chrono::days(1) - (morning - evening);
+    }
+}
+
+Schedule forecast(TimePoint time, std::chrono::seconds morning, std::chrono::seconds evening, std::chrono::milliseconds transitionDuration, int cycleCount)
+{
+    Schedule schedule;
+    schedule.cycles.reserve(cycleCount + 1);
+
+    const std::chrono::seconds halfOfDaylight = daylightDuration(morning, evening) / 2;
+    const std::chrono::seconds noon = (morning + halfOfDaylight) % std::chrono::days(1);
+    const std::tm localTime = toLocalTime(time);
+    for (int day = -1; day < cycleCount; ++day) {
+        std::tm localNoon = localTime;
+        localNoon.tm_mday += day;
+        localNoon.tm_hour = std::chrono::duration_cast<std::chrono::hours>(noon).count();
+        localNoon.tm_min = std::chrono::duration_cast<std::chrono::minutes>(noon % 1h).count();
+        localNoon.tm_sec = (noon % 1min).count();
+
+        const TimePoint noonTime = fromLocalTime(localNoon);
+        const TimePoint startOfMorning = noonTime - halfOfDaylight;
+        const TimePoint startOfEvening = noonTime + halfOfDaylight;
+
+        schedule.cycles.push_back(Cycle{
+            .noon = noonTime,
+            .morning = Transition{
+                .type = Transition::Morning,
+                .start = startOfMorning,
+                .end = startOfMorning + transitionDuration,
+            },
+            .evening = Transition{
+                .type = Transition::Evening,
+                .start = startOfEvening,
+                .end = startOfEvening + transitionDuration,
+            },
+        });
+    }
+
+    return schedule;
+}
+
+static double radians(double degrees)
+{
+    return degrees * std::numbers::pi / 180.0;
+}
+
+static double degrees(double radians)
+{
+    return radians * 180.0 / std::numbers::pi;
+}
+
+std::optional<SunEvents> sunEvents(TimePoint time, double latitude, double longitude, int dayOffset)
+{
+    // See the NOAA solar calculator, https://gml.noaa.gov/grad/solcalc/calcdetails.html. The
+    // longitude is positive to the east.
+    const double unixDays = time.time_since_epoch().count() / 86400000.0;
+    const double day = std::round(unixDays - 0.5 + longitude / 360.0) + dayOffset;
+    const double julianDay = 2440587.5 + day + (720.0 - 4.0 * longitude) / 1440.0;
+    const double julianCentury = (julianDay - 2451545.0) / 36525.0;
+
+    const double meanLongitude = std::fmod(280.46646 + julianCentury * (36000.76983 + julianCentury * 0.0003032), 360.0);
+    const double meanAnomaly = 357.52911 + julianCentury * (35999.05029 - 0.0001537 * julianCentury);
+    const double eccentricity = 0.016708634 - julianCentury * (0.000042037 + 0.0000001267 * julianCentury);
+    const double center = std::sin(radians(meanAnomaly)) * (1.914602 - julianCentury * (0.004817 + 0.000014 * julianCentury))
+        + std::sin(radians(2 * meanAnomaly)) * (0.019993 - 0.000101 * julianCentury)
+        + std::sin(radians(3 * meanAnomaly)) * 0.000289;
+    const double apparentLongitude = meanLongitude + center - 0.00569 - 0.00478 * std::sin(radians(125.04 - 1934.136 * julianCentury));
+    const double meanObliquity = 23.0 + (26.0 + (21.448 - julianCentury * (46.815 + julianCentury * (0.00059 - julianCentury * 0.001813))) / 60.0) / 60.0;
+    const double obliquity = meanObliquity + 0.00256 * std::cos(radians(125.04 - 1934.136 * julianCentury));
+    const double declination = std::asin(std::sin(radians(obliquity)) * std::sin(radians(apparentLongitude)));
+
+    const double y = std::pow(std::tan(radians(obliquity / 2.0)), 2);
+    const double equationOfTime = 4.0 * degrees(y * std::sin(2.0 * radians(meanLongitude)) //
+                                                - 2.0 * eccentricity * std::sin(radians(meanAnomaly)) //
+                                                + 4.0 * eccentricity * y * std::sin(radians(meanAnomaly)) * std::cos(2.0 * radians(meanLongitude)) //
+                                                - 0.5 * y * y * std::sin(4.0 * radians(meanLongitude)) //
+                                                - 1.25 * eccentricity * eccentricity * std::sin(2.0 * radians(meanAnomaly)));
+
+    // The solar noon and the hour angles are in minutes.
+    const double noon = 720.0 - 4.0 * longitude - equationOfTime;
+    const auto hourAngle = [&](double zenith) -> std::optional<double> {
+        const double cosine = std::cos(radians(zenith)) / (std::cos(radians(latitude)) * std::cos(declination)) - std::tan(radians(latitude)) * std::tan(declination);
+        if (cosine < -1.0 || cosine > 1.0) {
+            return std::nullopt;
+        }
+        return 4.0 * degrees(std::acos(cosine));
+    };
+
+    // The sunrise and the sunset account for the refraction and the solar disc size.
+    const auto sunHourAngle = hourAngle(90.833);
+    if (!sunHourAngle) {
+        return std::nullopt;
+    }
+
+    const auto civilHourAngle = hourAngle(96.0);
+    if (!civilHourAngle) {
+        return std::nullopt;
+    }
+
+    // The equations are accurate to a minute at best, the times are rounded to whole seconds so
+    // that they do not depend on the last bits of the floating point maths.
+    const TimePoint midnight = std::chrono::sys_days(std::chrono::days(std::int64_t(day)));
+    const auto at = [&midnight](double minutes) {
+        return midnight + std::chrono::seconds(std::llround(minutes * 60.0));
+    };
+
+    return SunEvents{
+        .civilDawn = at(noon - *civilHourAngle),
+        .sunrise = at(noon - *sunHourAngle),
+        .solarNoon = at(noon),
+        .sunset = at(noon + *sunHourAngle),
+        .civilDusk = at(noon + *civilHourAngle),
+    };
+}
+
+std::optional<Schedule> forecast(TimePoint time, double latitude, double longitude, int cycleCount)
+{
+    Schedule schedule;
+    schedule.cycles.reserve(cycleCount + 1);
+
+    // The days are counted from the local date, like in the timed forecast. The solar noon closest
+    // to the local noon falls on the same date unless the time zone is far off the longitude.
+    std::tm localNoon = toLocalTime(time);
+    localNoon.tm_hour = 12;
+    localNoon.tm_min = 0;
+    localNoon.tm_sec = 0;
+    const TimePoint reference = fromLocalTime(localNoon);
+
+    for (int day = -1; day < cycleCount; ++day) {
+        const auto events = sunEvents(reference, latitude, longitude, day);
+        if (!events) {
+            return std::nullopt;
+        }
+
+        schedule.cycles.push_back(Cycle{
+            .noon = events->solarNoon,
+            .morning = Transition{
+                .type = Transition::Morning,
+                .start = events->civilDawn,
+                .end = events->sunrise,
+            },
+            .evening = Transition{
+                .type = Transition::Evening,
+                .start = events->sunset,
+                .end = events->civilDusk,
+            },
+        });
+    }
+
+    return schedule;
+}
+
+} // namespace KNightTimeCore
@@ -0,0 +1,215 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*!
+ * \namespace KNightTimeCore
+ * \inmodule KNightTime
+ * \brief The KNightTimeCore namespace contains the dark-light cycle maths without any Qt dependencies.
+ *
+ * The types in this namespace mirror KDarkLightTransition, KDarkLightCycle, and KDarkLightSchedule,
+ * but they use plain \c std::chrono time points in milliseconds since the epoch. Conversions
+ * between the local time and UTC are done using the C library, so the \c TZ environment variable
+ * is respected.
+ *
+ * The state strings produced by KNightTimeCore::toState() and KDarkLightSchedule::toState() are
+ * interchangeable.
+ */
+namespace KNightTimeCore
+{
+
+using TimePoint = std::chrono::sys_time<std::chrono::milliseconds>;
+
+/*!
+ * \class KNightTimeCore::Transition
+ * \inmodule KNightTime
+ * \brief The Transition type represents a transition from day to night or vice versa.
+ */
+struct Transition
+{
+    enum Type : std::int32_t {
+        Morning,
+        Evening,
+    };
+
+    enum Relation {
+        Upcoming,
+        InProgress,
+        Passed,
+    };
+
+    auto operator<=>(const Transition &other) const = default;
+
+    /*!
+     * Checks how the specified \a time relates to this transition. Whole seconds are compared
+     * with a tolerance of one minute, same as in KDarkLightTransition::test().
+     */
+    Relation test(TimePoint time) const
+    {
+        using namespace std::chrono_literals;
+        if (std::chrono::duration_cast<std::chrono::seconds>(start - time) > 60s) {
+            return Upcoming;
+        } else if (std::chrono::duration_cast<std::chrono::seconds>(end - time) > 60s) {
+            return InProgress;
+        } else {
+            return Passed;
+        }
+    }
+
+    /*!
+     * Returns the progress of the transition at the specified \a time in [0.0, 1.0] range.
+     */
+    double progress(TimePoint time) const
+    {
+        const double elapsed = std::chrono::duration_cast<std::chrono::seconds>(time - start).count();
+        const double total = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
+        return std::clamp(elapsed / total, 0.0, 1.0);
+    }
+
+    Type type = Morning;
+    TimePoint start;
+    TimePoint end;
+};
+
+/*!
+ * \class KNightTimeCore::Cycle
+ * \inmodule KNightTime
+ * \brief The Cycle type provides information about the light-dark cycle for a single day.
+ */
+struct Cycle
+{
+    auto operator<=>(const Cycle &other) const = default;
+
+    /*!
+     * Computes a new cycle that includes the specified \a reference time. The noon keeps its
+     * local time of day, and the transitions keep their distance to the noon.
+     */
+    Cycle extrapolated(TimePoint reference) const;
+
+    /*!
+     * Returns the next transition for the specified \a time, or \c std::nullopt if the time
+     * comes after the evening.
+     */
+    std::optional<Transition> nextTransition(TimePoint time) const
+    {
+        if (morning.test(time) == Transition::Upcoming) {
+            return morning;
+        }
+        if (evening.test(time) == Transition::Upcoming) {
+            return evening;
+        }
+        return std::nullopt;
+    }
+
+    /*!
+     * Returns the previous transition for the specified \a time, or \c std::nullopt if the time
+     * comes before the morning.
+     */
+    std::optional<Transition> previousTransition(TimePoint time) const
+    {
+        if (evening.test(time) != Transition::Upcoming) {
+            return evening;
+        }
+        if (morning.test(time) != Transition::Upcoming) {
+            return morning;
+        }
+        return std::nullopt;
+    }
+
+    TimePoint noon;
+    Transition morning;
+    Transition evening;
+};
+
+/*!
+ * \class KNightTimeCore::Schedule
+ * \inmodule KNightTime
+ * \brief The Schedule type represents a schedule for the dark-light cycle.
+ */
+struct Schedule
+{
+    auto operator<=>(const Schedule &other) const = default;
+
+    /*!
+     * Finds the previous transition for the specified \a reference time. If the schedule has no
+     * cycles, a \c std::nullopt value will be returned.
+     */
+    std::optional<Transition> previousTransition(TimePoint reference) const;
+
+    /*!
+     * Finds the next transition for the specified \a reference time. If the schedule has no
+     * cycles, a \c std::nullopt value will be returned.
+     */
+    std::optional<Transition> nextTransition(TimePoint reference) const;
+
+    std::vector<Cycle> cycles;
+};
+
+/*!
+ * \class KNightTimeCore::SunEvents
+ * \inmodule KNightTime
+ * \brief The SunEvents type contains the solar events of a single day.
+ */
+struct SunEvents
+{
+    TimePoint civilDawn;
+    TimePoint sunrise;
+    TimePoint solarNoon;
+    TimePoint sunset;
+    TimePoint civilDusk;
+};
+
+/*!
+ * Computes the solar events of the day whose solar noon is the closest to the specified \a time
+ * at the given location (\a latitude, \a longitude in decimal degrees). The \a dayOffset selects
+ * one of the following or preceding days.
+ *
+ * The times are rounded to whole seconds.
+ *
+ * This function returns \c std::nullopt if the Sun does not rise or set on that day, or if it
+ * does not go far enough below the horizon for the civil twilight to end.
+ */
+std::optional<SunEvents> sunEvents(TimePoint time, double latitude, double longitude, int dayOffset = 0);
+
+/*!
+ * Computes the dark-light schedule for the next \a cycleCount days, see KDarkLightSchedule::forecast().
+ * The \a morning and \a evening are offsets from the local midnight.
+ */
+Schedule forecast(TimePoint time,
+                  std::chrono::seconds morning = std::chrono::hours(6),
+                  std::chrono::seconds evening = std::chrono::hours(18),
+                  std::chrono::milliseconds transitionDuration = std::chrono::minutes(30),
+                  int cycleCount = 7);
+
+/*!
+ * Computes the dark-light schedule for the next \a cycleCount days based on the position of
+ * the Sun at the given location, see KDarkLightSchedule::forecast(). The days are counted from
+ * the local date of the specified \a time.
+ */
+std::optional<Schedule> forecast(TimePoint time, double latitude, double longitude, int cycleCount = 7);
+
+/*!
+ * Serializes the \a schedule in a string that can be stored in a config. An empty schedule
+ * produces an empty string.
+ */
+std::string toState(const Schedule &schedule);
+
+/*!
+ * Loads a schedule from the specified \a state string. If the \a state is empty or invalid, a
+ * \c std::nullopt value will be returned.
+ */
+std::optional<Schedule> fromState(std::string_view state);
+
+} // namespace KNightTimeCore
@@ -0,0 +1,243 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knighttimecore.h"
+
+#include <array>
+
+using namespace std::chrono_literals;
+
+/*
+ * The state is the base64 encoding of what QDataStream would write: all numbers are big-endian,
+ * the version and the number of cycles are 32-bit integers, every cycle is the noon time followed
+ * by the morning and the evening transitions, and every transition is a 32-bit type followed
+ * by 64-bit start and end times in milliseconds since the epoch.
+ */
+
+namespace KNightTimeCore
+{
+
+static constexpr std::int32_t s_stateVersion = 1;
+static constexpr std::string_view s_base64Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+class StateWriter
+{
+public:
+    void writeInt32(std::int32_t value)
+    {
+        writeBigEndian(std::uint32_t(value), 4);
+    }
+
+    void writeInt64(std::int64_t value)
+    {
+        writeBigEndian(std::uint64_t(value), 8);
+    }
+
+    void writeTime(TimePoint time)
+    {
+        writeInt64(time.time_since_epoch().count());
+    }
+
+    std::string toBase64() const
+    {
+        std::string base64;
+        base64.reserve((m_bytes.size() + 2) / 3 * 4);
+
+        for (size_t i = 0; i < m_bytes.size(); i += 3) {
+            const size_t available = std::min<size_t>(3, m_bytes.size() - i);
+
+            std::uint32_t chunk = std::uint32_t(m_bytes[i]) << 16;
+            if (available > 1) {
+                chunk |= std::uint32_t(m_bytes[i + 1]) << 8;
+            }
+            if (available > 2) {
+                chunk |= std::uint32_t(m_bytes[i + 2]);
+            }
+
+            base64 += s_base64Alphabet[(chunk >> 18) & 0x3f];
+            base64 += s_base64Alphabet[(chunk >> 12) & 0x3f];
+            base64 += available > 1 ? s_base64Alphabet[(chunk >> 6) & 0x3f] : '=';
+            base64 += available > 2 ? s_base64Alphabet[chunk & 0x3f] : '=';
+        }
+
+        return base64;
+    }
+
+private:
+    void writeBigEndian(std::uint64_t value, int size)
+    {
+        for (int i = size - 1; i >= 0; --i) {
+            m_bytes.push_back(std::uint8_t(value >> (i * 8)));
+        }
+    }
+
+    std::vector<std::uint8_t> m_bytes;
+};
+
+class StateReader
+{
+public:
+    explicit StateReader(std::string_view base64)
+    {
+        std::array<std::int8_t, 256> lookup;
+        lookup.fill(-1);
+        for (size_t i = 0; i < s_base64Alphabet.size(); ++i) {
+            lookup[std::uint8_t(s_base64Alphabet[i])] = i;
+        }
+
+        // Like QByteArray::fromBase64(), unknown characters are skipped and padding ends the data.
+        m_bytes.reserve(base64.size() * 3 / 4);
+        std::uint32_t chunk = 0;
+        int bits = 0;
+        for (const char character : base64) {
+            if (character == '=') {
+                break;
+            }
+            const std::int8_t value = lookup[std::uint8_t(character)];
+            if (value == -1) {
+                continue;
+            }
+            chunk = (chunk << 6) | std::uint32_t(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                m_bytes.push_back(std::uint8_t(chunk >> bits));
+            }
+        }
+    }
+
+    std::optional<std::int32_t> readInt32()
+    {
+        if (const auto value = readBigEndian(4)) {
+            return std::int32_t(std::uint32_t(*value));
+        }
+        return std::nullopt;
+    }
+
+    std::optional<TimePoint> readTime()
+    {
+        if (const auto value = readBigEndian(8)) {
+            return TimePoint(std::chrono::milliseconds(std::int64_t(*value)));
+        }
+        return std::nullopt;
+    }
+
+private:
+    std::optional<std::uint64_t> readBigEndian(size_t size)
+    {
+        if (m_bytes.size() - m_position < size) {
+            return std::nullopt;
+        }
+
+        std::uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value << 8) | m_bytes[m_position++];
+        }
+        return value;
+    }
+
+    std::vector<std::uint8_t> m_bytes;
+    size_t m_position = 0;
+};
+
+static void serializeTransition(StateWriter &writer, const Transition &transition)
+{
+    writer.writeInt32(transition.type);
+    writer.writeTime(transition.start);
+    writer.writeTime(transition.end);
+}
+
+static std::optional<Transition> deserializeTransition(StateReader &reader)
+{
+    const auto type = reader.readInt32();
+    const auto start = reader.readTime();
+    const auto end = reader.readTime();
+    if (!type || !start || !end) {
+        return std::nullopt;
+    }
+
+    if (start->time_since_epoch() == 0ms || end->time_since_epoch() == 0ms) {
+        return std::nullopt;
+    }
+
+    switch (*type) {
+    case Transition::Morning:
+    case Transition::Evening:
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    return Transition{
+        .type = Transition::Type(*type),
+        .start = *start,
+        .end = *end,
+    };
+}
+
+std::string toState(const Schedule &schedule)
+{
+    if (schedule.cycles.empty()) {
+        return std::string();
+    }
+
+    StateWriter writer;
+    writer.writeInt32(s_stateVersion);
+    writer.writeInt32(schedule.cycles.size());
+    for (const Cycle &cycle : schedule.cycles) {
+        writer.writeTime(cycle.noon);
+        serializeTransition(writer, cycle.morning);
+        serializeTransition(writer, cycle.evening);
+    }
+
+    return writer.toBase64();
+}
+
+std::optional<Schedule> fromState(std::string_view state)
+{
+    if (state.empty()) {
+        return std::nullopt;
+    }
+
+    StateReader reader(state);
+    if (reader.readInt32() != s_stateVersion) {
+        return std::nullopt;
+    }
+
+    const auto count = reader.readInt32();
+    if (!count || *count < 0) {
+        return std::nullopt;
+    }
+
+    Schedule schedule;
+    schedule.cycles.reserve(std::min(*count, 64));
+    for (int i = 0; i < *count; ++i) {
+        const auto noon = reader.readTime();
+        if (!noon || noon->time_since_epoch() == 0ms) {
+            return std::nullopt;
+        }
+
+        const auto morning = deserializeTransition(reader);
+        if (!morning) {
+            return std::nullopt;
+        }
+
+        const auto evening = deserializeTransition(reader);
+        if (!evening) {
+            return std::nullopt;
+        }
+
+        schedule.cycles.push_back(Cycle{
+            .noon = *noon,
+            .morning = *morning,
+            .evening = *evening,
+        });
+    }
+
+    return schedule;
+}
+
+} // namespace KNightTimeCore
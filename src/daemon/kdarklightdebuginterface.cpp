@@ -0,0 +1,76 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kdarklightdebuginterface.h"
+#include "kdarklightmanager.h"
+#include "kdarklightmanagerinterface.h"
+#include "kdarklightschedulecache.h"
+#include "knighttimetrace_p.h"
+
+#include <QDBusConnection>
+#include <QDir>
+#include <QStandardPaths>
+
+KDarkLightDebugInterface::KDarkLightDebugInterface(KDarkLightManager *manager, KDarkLightManagerInterface *managerInterface, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_managerInterface(managerInterface)
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/NightTime/Debug"), this, QDBusConnection::ExportScriptableContents);
+}
+
+QVariantMap KDarkLightDebugInterface::GetMetrics()
+{
+    QVariantMap metrics = m_manager->metrics()->toVariantMap();
+    metrics[QStringLiteral("Subscribers")] = m_managerInterface->subscriberCount();
+    metrics[QStringLiteral("SubscribedServices")] = m_managerInterface->subscribedServiceCount();
+    metrics[QStringLiteral("Leases")] = m_managerInterface->leaseCount();
+    metrics[QStringLiteral("ScheduleCacheHits")] = qulonglong(m_manager->scheduleCache()->hits());
+    metrics[QStringLiteral("ScheduleCacheMisses")] = qulonglong(m_manager->scheduleCache()->misses());
+    return metrics;
+}
+
+uint KDarkLightDebugInterface::subscriberCount() const
+{
+    return m_managerInterface->subscriberCount();
+}
+
+uint KDarkLightDebugInterface::subscribedServiceCount() const
+{
+    return m_managerInterface->subscribedServiceCount();
+}
+
+uint KDarkLightDebugInterface::leaseCount() const
+{
+    return m_managerInterface->leaseCount();
+}
+
+QString KDarkLightDebugInterface::StartTracing(const QString &name)
+{
+    // Any client on the session bus can call this, so it must not be able to pick where the daemon writes.
+    if (name.isEmpty() || name.contains(QLatin1Char('/')) || name == QLatin1String(".") || name == QLatin1String("..")) {
+        sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("The trace name must be a plain file name"));
+        return QString();
+    }
+
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/knighttime/traces");
+    QDir().mkpath(directory);
+
+    const QString fileName = directory + QLatin1Char('/') + name;
+    if (!KNightTimeTracer::self()->start(fileName)) {
+        sendErrorReply(QDBusError::Failed, QStringLiteral("Failed to open the trace file"));
+        return QString();
+    }
+
+    return fileName;
+}
+
+void KDarkLightDebugInterface::StopTracing()
+{
+    KNightTimeTracer::self()->stop();
+}
+
+#include "moc_kdarklightdebuginterface.cpp"
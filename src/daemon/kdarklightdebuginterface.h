@@ -0,0 +1,39 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QDBusContext>
+#include <QObject>
+#include <QVariant>
+
+class KDarkLightManager;
+class KDarkLightManagerInterface;
+
+class KDarkLightDebugInterface : public QObject, public QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.NightTime.Debug")
+    Q_PROPERTY(uint Subscribers READ subscriberCount)
+    Q_PROPERTY(uint SubscribedServices READ subscribedServiceCount)
+    Q_PROPERTY(uint Leases READ leaseCount)
+
+public:
+    explicit KDarkLightDebugInterface(KDarkLightManager *manager, KDarkLightManagerInterface *managerInterface, QObject *parent = nullptr);
+
+    uint subscriberCount() const;
+    uint subscribedServiceCount() const;
+    uint leaseCount() const;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QVariantMap GetMetrics();
+    Q_SCRIPTABLE QString StartTracing(const QString &name);
+    Q_SCRIPTABLE void StopTracing();
+
+private:
+    KDarkLightManager *m_manager;
+    KDarkLightManagerInterface *m_managerInterface;
+};
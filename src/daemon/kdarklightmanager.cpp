@@ -5,16 +5,25 @@
 */
 
 #include "kdarklightmanager.h"
+#include "kdarklightdebuginterface.h"
 #include "kdarklightmanagerinterface.h"
+#include "kdarklightschedulecache.h"
 #include "kdarklightsettings.h"
 #include "kdarklightstate.h"
+#include "knighttimeclock_p.h"
+#include "knighttimetrace_p.h"
+#include "kpositionupdatecontroller.h"
+#include "kreplaypositioninfosource.h"
+#include "kshareddarklightscheduler.h"
+#include "ksleepmonitor.h"
 #include "ksolardarklightscheduler.h"
 #include "ktimeddarklightscheduler.h"
 
 #include <KSharedConfig>
-#include <KSystemClockSkewNotifier>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 
 using namespace std::chrono_literals;
 
@@ -65,15 +74,64 @@ static void migrateNightLightConfig(KDarkLightSettings *knighttimerc)
     }
 }
 
+static std::unique_ptr<KDarkLightSettings> loadSettings()
+{
+    KNIGHTTIME_TRACE_SCOPE("startup", "loadSettings");
+    return std::make_unique<KDarkLightSettings>(KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals));
+}
+
+static std::unique_ptr<KDarkLightState> loadState()
+{
+    KNIGHTTIME_TRACE_SCOPE("startup", "loadState");
+    return std::make_unique<KDarkLightState>();
+}
+
+static QGeoPositionInfoSource *createPositionInfoSource(KNightTimeClock *clock, QObject *parent)
+{
+    // Recorded positions can be replayed to reproduce or benchmark automatic location handling.
+    if (const QString replayFileName = qEnvironmentVariable("KNIGHTTIMED_POSITION_REPLAY"); !replayFileName.isEmpty()) {
+        bool ok;
+        const qreal speed = qEnvironmentVariable("KNIGHTTIMED_POSITION_REPLAY_SPEED").toDouble(&ok);
+        return new KReplayPositionInfoSource(replayFileName, ok ? speed : 1.0, clock, parent);
+    }
+
+    const QVariantMap parameters{
+        {QStringLiteral("desktopId"), QStringLiteral("org.kde.knighttimed")},
+    };
+
+    // This loads the positioning plugins.
+    KNIGHTTIME_TRACE_SCOPE("startup", "createPositionSource");
+    return QGeoPositionInfoSource::createDefaultSource(parameters, parent);
+}
+
 KDarkLightManager::KDarkLightManager(QObject *parent)
+    : KDarkLightManager(KNightTimeClock::system(), parent)
+{
+}
+
+KDarkLightManager::KDarkLightManager(KNightTimeClock *clock, QObject *parent)
     : QObject(parent)
+    , m_clock(clock)
     , m_dbusInterface(std::make_unique<KDarkLightManagerInterface>(this))
-    , m_settings(std::make_unique<KDarkLightSettings>(KSharedConfig::openConfig(QStringLiteral("knighttimerc"), KConfig::NoGlobals)))
-    , m_state(std::make_unique<KDarkLightState>())
-    , m_skewNotifier(std::make_unique<KSystemClockSkewNotifier>())
-    , m_scheduleTimer(std::make_unique<QTimer>())
+    , m_settings(loadSettings())
+    , m_state(loadState())
+    , m_scheduleCache(std::make_unique<KDarkLightScheduleCache>(KDarkLightScheduleCache::defaultFileName()))
+    , m_sleepMonitor(std::make_unique<KSleepMonitor>())
+    , m_scheduleTimer(clock->createTimer())
+    , m_idleTimer(clock->createTimer())
 {
-    migrateNightLightConfig(m_settings.get());
+    if (qEnvironmentVariableIntValue("KNIGHTTIMED_DEBUG_INTERFACE")) {
+        m_debugInterface = std::make_unique<KDarkLightDebugInterface>(this, m_dbusInterface.get());
+    }
+
+    // Opening kwinrc is not free, and there is nothing left to migrate after the first run.
+    if (!m_state->nightLightConfigMigrated()) {
+        KNIGHTTIME_TRACE_SCOPE("startup", "migrateConfig");
+        migrateNightLightConfig(m_settings.get());
+        m_state->setNightLightConfigMigrated(true);
+        m_state->save();
+        m_metrics.stateWrites++;
+    }
 
     m_configWatcher = KConfigWatcher::create(m_settings->sharedConfig());
     connect(m_configWatcher.get(), &KConfigWatcher::configChanged, this, [this]() {
@@ -81,16 +139,37 @@ KDarkLightManager::KDarkLightManager(QObject *parent)
         reconfigure();
     });
 
-    m_scheduleTimer->setSingleShot(false);
-    m_scheduleTimer->setInterval(24h);
-    connect(m_scheduleTimer.get(), &QTimer::timeout, this, &KDarkLightManager::reschedule);
+    connect(m_scheduleTimer.get(), &KNightTimeTimer::timeout, this, [this]() {
+        KNIGHTTIME_TRACE_INSTANT("manager", "scheduleTimer");
+        reschedule();
+    });
+
+    connect(m_clock, &KNightTimeClock::skewed, this, [this]() {
+        KNIGHTTIME_TRACE_INSTANT("manager", "clockSkewed");
+
+        // The clock jumps when the system resumes, the schedule will be updated once it is awake.
+        if (!m_sleepMonitor->isSleeping()) {
+            reschedule();
+        }
+    });
+
+    connect(m_sleepMonitor.get(), &KSleepMonitor::aboutToSleep, this, &KDarkLightManager::prepareForSleep);
+    connect(m_sleepMonitor.get(), &KSleepMonitor::resumed, this, &KDarkLightManager::resume);
 
-    m_skewNotifier->setActive(true);
-    connect(m_skewNotifier.get(), &KSystemClockSkewNotifier::skewed, this, &KDarkLightManager::reschedule);
+    connect(m_idleTimer.get(), &KNightTimeTimer::timeout, this, [this]() {
+        KNIGHTTIME_TRACE_INSTANT("manager", "idle");
+
+        // The schedule is computed again from the settings when the daemon is started the next time.
+        m_dbusInterface->shutdown();
+        Q_EMIT idle();
+    });
+    connect(m_dbusInterface.get(), &KDarkLightManagerInterface::subscribersChanged, this, &KDarkLightManager::updateIdleTimer);
 }
 
 KDarkLightManager::~KDarkLightManager()
 {
+    // A change can still be waiting for the end of the coalescing window.
+    m_dbusInterface->saveCache();
 }
 
 KDarkLightSchedule KDarkLightManager::schedule() const
@@ -98,67 +177,286 @@ KDarkLightSchedule KDarkLightManager::schedule() const
     return m_schedule;
 }
 
-void KDarkLightManager::reconfigure()
+bool KDarkLightManager::isScheduleAccurate() const
 {
-    m_positionInfoSource.reset();
-    m_scheduler.reset();
+    return m_scheduleAccurate;
+}
+
+void KDarkLightManager::setScheduleAccurate(bool accurate)
+{
+    if (m_scheduleAccurate != accurate) {
+        m_scheduleAccurate = accurate;
+        Q_EMIT scheduleAccurateChanged();
+    }
+}
+
+KDarkLightMetrics *KDarkLightManager::metrics()
+{
+    return &m_metrics;
+}
+
+KDarkLightScheduleCache *KDarkLightManager::scheduleCache() const
+{
+    return m_scheduleCache.get();
+}
+
+KDarkLightManager::Configuration KDarkLightManager::effectiveConfiguration() const
+{
+    // Only the settings that the current source depends on are included, so changing the others does not cause any work.
+    Configuration configuration{
+        .source = m_settings->source(),
+        .sharedInstance = m_settings->sharedInstance(),
+    };
 
     switch (m_settings->source()) {
-    case KDarkLightSettings::Location: {
-        if (m_settings->automaticLocation()) {
-            const QVariantMap parameters{
-                {QStringLiteral("desktopId"), QStringLiteral("org.kde.knighttimed")},
-            };
-
-            if (auto source = QGeoPositionInfoSource::createDefaultSource(parameters, this)) {
-                m_positionInfoSource.reset(source);
-                connect(m_positionInfoSource.get(), &QGeoPositionInfoSource::errorOccurred, this, [this]() {
-                    m_scheduler = std::make_unique<KTimedDarkLightScheduler>(m_settings->sunriseStart(), m_settings->sunsetStart(), m_settings->transitionDuration());
-                    reschedule();
-                });
-                connect(m_positionInfoSource.get(), &QGeoPositionInfoSource::positionUpdated, this, [this](const QGeoPositionInfo &update) {
-                    const QGeoCoordinate coordinate = update.coordinate();
-                    m_state->setAvailable(true);
-                    m_state->setLatitude(coordinate.latitude());
-                    m_state->setLongitude(coordinate.longitude());
-                    m_state->save();
-
-                    const int minDistanceInMeters = 50000;
-                    const auto currentScheduler = dynamic_cast<KSolarDarkLightScheduler *>(m_scheduler.get());
-                    if (!currentScheduler || coordinate.distanceTo(currentScheduler->coordinate()) > minDistanceInMeters) {
-                        m_scheduler = std::make_unique<KSolarDarkLightScheduler>(coordinate);
-                        reschedule();
-                    }
-                });
-
-                m_positionInfoSource->startUpdates();
-                if (m_state->available()) {
-                    m_scheduler = std::make_unique<KSolarDarkLightScheduler>(QGeoCoordinate(m_state->latitude(), m_state->longitude()));
-                    break;
-                }
+    case KDarkLightSettings::Location:
+        configuration.automaticLocation = m_settings->automaticLocation();
+        if (!configuration.automaticLocation) {
+            configuration.manualLocation = QGeoCoordinate(m_settings->manualLatitude(), m_settings->manualLongitude());
+            break;
+        }
+        // The times are used until the location is known.
+        [[fallthrough]];
+    case KDarkLightSettings::Times:
+        configuration.sunriseStart = m_settings->sunriseStart();
+        configuration.sunsetStart = m_settings->sunsetStart();
+        configuration.transitionDuration = m_settings->transitionDuration();
+        break;
+    }
+
+    return configuration;
+}
+
+std::unique_ptr<KDarkLightScheduler> KDarkLightManager::createFallbackScheduler() const
+{
+    auto scheduler = std::make_unique<KTimedDarkLightScheduler>(m_settings->sunriseStart(), m_settings->sunsetStart(), m_settings->transitionDuration());
+    if (m_settings->sharedInstance()) {
+        const QVariantMap configuration = KSharedDarkLightScheduler::timesConfiguration(m_settings->sunriseStart(), m_settings->sunsetStart(), m_settings->transitionDuration());
+        return std::make_unique<KSharedDarkLightScheduler>(configuration, std::move(scheduler));
+    }
+    return scheduler;
+}
+
+std::unique_ptr<KDarkLightScheduler> KDarkLightManager::createLocationScheduler(const QGeoCoordinate &coordinate) const
+{
+    auto scheduler = std::make_unique<KSolarDarkLightScheduler>(coordinate, m_scheduleCache.get());
+    if (m_settings->sharedInstance()) {
+        const QVariantMap configuration = KSharedDarkLightScheduler::locationConfiguration(coordinate.latitude(), coordinate.longitude());
+        return std::make_unique<KSharedDarkLightScheduler>(configuration, std::move(scheduler));
+    }
+    return scheduler;
+}
+
+std::unique_ptr<KDarkLightScheduler> KDarkLightManager::createAutomaticLocationScheduler(const QGeoCoordinate &coordinate) const
+{
+    if (!m_settings->sharedInstance()) {
+        return std::make_unique<KSolarDarkLightScheduler>(coordinate, m_scheduleCache.get());
+    }
+
+    // Only a coarse position is sent to the system instance. It is enough for the sessions in the same
+    // place to share a schedule, and it moves the transitions by a few seconds at most.
+    const auto coarse = [](qreal degrees) {
+        return std::round(degrees * 100) / 100;
+    };
+    return createLocationScheduler(QGeoCoordinate(coarse(coordinate.latitude()), coarse(coordinate.longitude())));
+}
+
+KSolarDarkLightScheduler *KDarkLightManager::solarScheduler() const
+{
+    // The shared scheduler falls back to the same forecast computed locally.
+    if (const auto sharedScheduler = dynamic_cast<KSharedDarkLightScheduler *>(m_scheduler.get())) {
+        return dynamic_cast<KSolarDarkLightScheduler *>(sharedScheduler->fallback());
+    }
+    return dynamic_cast<KSolarDarkLightScheduler *>(m_scheduler.get());
+}
+
+void KDarkLightManager::setScheduler(std::unique_ptr<KDarkLightScheduler> &&scheduler)
+{
+    m_scheduler = std::move(scheduler);
+    if (const auto sharedScheduler = dynamic_cast<KSharedDarkLightScheduler *>(m_scheduler.get())) {
+        connect(sharedScheduler, &KSharedDarkLightScheduler::scheduleChanged, this, &KDarkLightManager::reschedule);
+    }
+    reschedule();
+}
+
+void KDarkLightManager::startPositionUpdates()
+{
+    stopPositionUpdates();
+
+    m_positionInfoSource.reset(createPositionInfoSource(m_clock, this));
+    if (!m_positionInfoSource) {
+        return;
+    }
+
+    connect(m_positionInfoSource.get(), &QGeoPositionInfoSource::errorOccurred, this, [this](QGeoPositionInfoSource::Error error) {
+        KNIGHTTIME_TRACE_SCOPE("manager", "positionError", QString::number(error));
+
+        // One-shot position requests may time out, keep using the last known location.
+        if (error == QGeoPositionInfoSource::UpdateTimeoutError && solarScheduler()) {
+            return;
+        }
+
+        setScheduler(createFallbackScheduler());
+
+        // The location is not going to be known any time soon, this is as good as it gets.
+        setScheduleAccurate(true);
+    });
+    connect(m_positionInfoSource.get(), &QGeoPositionInfoSource::positionUpdated, this, [this](const QGeoPositionInfo &update) {
+        KNIGHTTIME_TRACE_SCOPE("manager", "positionUpdated");
+        m_metrics.positionUpdatesReceived++;
+
+        const QGeoCoordinate coordinate = update.coordinate();
+        m_state->setAvailable(true);
+        m_state->setLatitude(coordinate.latitude());
+        m_state->setLongitude(coordinate.longitude());
+        if (m_state->isSaveNeeded()) {
+            m_metrics.stateWrites++;
+        }
+        m_state->save();
+
+        // Ignore the new position if the transitions would barely move. If that cannot be estimated,
+        // e.g. at the edge of the polar day, only a position far enough away is worth a new forecast.
+        bool significant = true;
+        if (const auto currentScheduler = solarScheduler()) {
+            if (const auto shift = currentScheduler->estimateTransitionShift(coordinate, m_clock->currentDateTime())) {
+                significant = *shift > std::chrono::seconds(m_settings->transitionShiftThreshold());
+            } else {
+                const int minDistanceInMeters = 50000;
+                significant = coordinate.distanceTo(currentScheduler->coordinate()) > minDistanceInMeters;
             }
+        }
 
-            m_scheduler = std::make_unique<KTimedDarkLightScheduler>(m_settings->sunriseStart(), m_settings->sunsetStart(), m_settings->transitionDuration());
+        if (significant) {
+            setScheduler(createAutomaticLocationScheduler(coordinate));
+            setScheduleAccurate(true);
         } else {
-            m_scheduler = std::make_unique<KSolarDarkLightScheduler>(QGeoCoordinate(m_settings->manualLatitude(), m_settings->manualLongitude()));
+            m_metrics.positionUpdatesIgnored++;
         }
-        break;
+    });
+
+    // Polling continuously can be useful to compare the update policies.
+    if (qEnvironmentVariable("KNIGHTTIMED_POSITION_UPDATES") == QLatin1String("continuous")) {
+        m_positionInfoSource->startUpdates();
+    } else {
+        m_positionUpdateController = std::make_unique<KPositionUpdateController>(m_positionInfoSource.get(), m_clock);
+        m_positionUpdateController->start();
     }
-    case KDarkLightSettings::Times:
-        m_scheduler = std::make_unique<KTimedDarkLightScheduler>(m_settings->sunriseStart(), m_settings->sunsetStart(), m_settings->transitionDuration());
-        break;
+    m_metrics.positionSourceStarts++;
+}
+
+void KDarkLightManager::stopPositionUpdates()
+{
+    m_positionUpdateController.reset();
+    m_positionInfoSource.reset();
+}
+
+void KDarkLightManager::reconfigure()
+{
+    KDarkLightHistogramScope metricsScope(m_metrics.reconfigure);
+    KNIGHTTIME_TRACE_SCOPE("manager", "reconfigure");
+
+    m_dbusInterface->setRefreshCoalescingInterval(std::chrono::milliseconds(m_settings->refreshCoalescingInterval()));
+    m_dbusInterface->setLeaseDuration(std::chrono::seconds(std::max(m_settings->subscriptionLeaseDuration(), 1u)));
+
+    const Configuration configuration = effectiveConfiguration();
+    if (m_configuration == configuration) {
+        updateIdleTimer();
+        return;
     }
+    m_configuration = configuration;
 
-    reschedule();
+    const bool automaticLocation = configuration.source == KDarkLightSettings::Location && configuration.automaticLocation;
+    if (!automaticLocation) {
+        stopPositionUpdates();
+    }
+
+    std::unique_ptr<KDarkLightScheduler> scheduler;
+    if (automaticLocation) {
+        if (!m_positionInfoSource) {
+            startPositionUpdates();
+            if (m_positionInfoSource && m_state->available()) {
+                scheduler = createAutomaticLocationScheduler(QGeoCoordinate(m_state->latitude(), m_state->longitude()));
+            } else {
+                scheduler = createFallbackScheduler();
+            }
+        } else if (!solarScheduler()) {
+            // The position source is kept running, but the location is still unknown.
+            scheduler = createFallbackScheduler();
+        } else if (configuration.sharedInstance != bool(dynamic_cast<KSharedDarkLightScheduler *>(m_scheduler.get()))) {
+            // The location is known, but the schedule is now computed by the other instance.
+            scheduler = createAutomaticLocationScheduler(QGeoCoordinate(m_state->latitude(), m_state->longitude()));
+        }
+    } else if (configuration.source == KDarkLightSettings::Location) {
+        scheduler = createLocationScheduler(configuration.manualLocation);
+    } else {
+        scheduler = createFallbackScheduler();
+    }
+
+    if (scheduler) {
+        setScheduler(std::move(scheduler));
+    }
+
+    // With the automatic location, the times are only a placeholder until the first position fix.
+    setScheduleAccurate(!m_positionInfoSource || solarScheduler());
+
+    updateIdleTimer();
 }
 
 void KDarkLightManager::reschedule()
 {
-    const auto schedule = m_scheduler->schedule(QDateTime::currentDateTime());
+    KDarkLightHistogramScope metricsScope(m_metrics.reschedule);
+    KNIGHTTIME_TRACE_SCOPE("manager", "reschedule");
+
+    const auto schedule = [this]() {
+        KNIGHTTIME_TRACE_SCOPE("manager", "forecast");
+        return m_scheduler->schedule(m_clock->currentDateTime());
+    }();
+
+    // The schedule covers only a few days ahead, so refresh it daily.
+    if (!m_sleepMonitor->isSleeping()) {
+        m_scheduleTimer->start(24h);
+    }
+
     if (m_schedule != schedule) {
         m_schedule = schedule;
+        m_metrics.scheduleChanges++;
         Q_EMIT scheduleChanged();
     }
 }
 
+void KDarkLightManager::prepareForSleep()
+{
+    KNIGHTTIME_TRACE_SCOPE("manager", "prepareForSleep");
+    m_metrics.sleeps++;
+
+    // The timers would fire late and one after another after resume, so they are stopped, and the
+    // subscribers are notified about the changes made in the meantime only once the system is awake.
+    m_scheduleTimer->stop();
+    m_dbusInterface->setRefreshPaused(true);
+}
+
+void KDarkLightManager::resume()
+{
+    KDarkLightHistogramScope metricsScope(m_metrics.resume);
+    KNIGHTTIME_TRACE_SCOPE("manager", "resume");
+
+    if (m_scheduler) {
+        reschedule();
+    }
+    m_dbusInterface->setRefreshPaused(false);
+}
+
+void KDarkLightManager::updateIdleTimer()
+{
+    const std::chrono::seconds timeout(m_settings->idleTimeout());
+    // A client that waits for the reply to Subscribe() counts as a subscriber too.
+    if (timeout.count() && !m_dbusInterface->subscriberCount() && !m_dbusInterface->pendingSubscriptionCount()) {
+        if (!m_idleTimer->isActive() || m_idleTimer->interval() != timeout) {
+            m_idleTimer->start(timeout);
+        }
+    } else {
+        m_idleTimer->stop();
+    }
+}
+
 #include "moc_kdarklightmanager.cpp"
@@ -6,17 +6,25 @@
 
 #pragma once
 
+#include "kdarklightmetrics.h"
 #include "kdarklightscheduler.h"
 
 #include <KConfigWatcher>
 
 #include <QGeoPositionInfoSource>
-#include <QTimer>
 
+#include <optional>
+
+class KDarkLightDebugInterface;
 class KDarkLightManagerInterface;
+class KDarkLightScheduleCache;
 class KDarkLightSettings;
 class KDarkLightState;
-class KSystemClockSkewNotifier;
+class KNightTimeClock;
+class KNightTimeTimer;
+class KPositionUpdateController;
+class KSleepMonitor;
+class KSolarDarkLightScheduler;
 
 class KDarkLightManager : public QObject
 {
@@ -24,24 +32,64 @@ class KDarkLightManager : public QObject
 
 public:
     explicit KDarkLightManager(QObject *parent = nullptr);
+    explicit KDarkLightManager(KNightTimeClock *clock, QObject *parent = nullptr);
     ~KDarkLightManager() override;
 
     KDarkLightSchedule schedule() const;
+    bool isScheduleAccurate() const;
+    KDarkLightMetrics *metrics();
+    KDarkLightScheduleCache *scheduleCache() const;
 
     void reconfigure();
     void reschedule();
 
 Q_SIGNALS:
     void scheduleChanged();
+    void scheduleAccurateChanged();
+    void idle();
 
 private:
+    struct Configuration
+    {
+        int source = 0;
+        bool automaticLocation = false;
+        QGeoCoordinate manualLocation;
+        QTime sunriseStart;
+        QTime sunsetStart;
+        uint transitionDuration = 0;
+        bool sharedInstance = false;
+
+        bool operator==(const Configuration &other) const = default;
+    };
+
+    Configuration effectiveConfiguration() const;
+    std::unique_ptr<KDarkLightScheduler> createFallbackScheduler() const;
+    std::unique_ptr<KDarkLightScheduler> createLocationScheduler(const QGeoCoordinate &coordinate) const;
+    std::unique_ptr<KDarkLightScheduler> createAutomaticLocationScheduler(const QGeoCoordinate &coordinate) const;
+    KSolarDarkLightScheduler *solarScheduler() const;
+    void setScheduler(std::unique_ptr<KDarkLightScheduler> &&scheduler);
+    void startPositionUpdates();
+    void stopPositionUpdates();
+    void updateIdleTimer();
+    void setScheduleAccurate(bool accurate);
+    void prepareForSleep();
+    void resume();
+
+    KNightTimeClock *m_clock;
     KConfigWatcher::Ptr m_configWatcher;
     std::unique_ptr<KDarkLightManagerInterface> m_dbusInterface;
+    std::unique_ptr<KDarkLightDebugInterface> m_debugInterface;
     std::unique_ptr<KDarkLightSettings> m_settings;
     std::unique_ptr<KDarkLightState> m_state;
+    std::unique_ptr<KDarkLightScheduleCache> m_scheduleCache;
     std::unique_ptr<KDarkLightScheduler> m_scheduler;
-    std::unique_ptr<KSystemClockSkewNotifier> m_skewNotifier;
     std::unique_ptr<QGeoPositionInfoSource> m_positionInfoSource;
-    std::unique_ptr<QTimer> m_scheduleTimer;
+    std::unique_ptr<KPositionUpdateController> m_positionUpdateController;
+    std::unique_ptr<KSleepMonitor> m_sleepMonitor;
+    std::unique_ptr<KNightTimeTimer> m_scheduleTimer;
+    std::unique_ptr<KNightTimeTimer> m_idleTimer;
+    std::optional<Configuration> m_configuration;
     KDarkLightSchedule m_schedule;
+    bool m_scheduleAccurate = false;
+    KDarkLightMetrics m_metrics;
 };
@@ -5,23 +5,50 @@
 */
 
 #include "kdarklightmanagerinterface.h"
-#include "kdarklightdbustypes_p.h"
 #include "kdarklightmanager.h"
+#include "kdarklightschedulefile_p.h"
+#include "knighttimetrace_p.h"
 
 #include <QDBusConnection>
 #include <QDBusMessage>
 #include <QDBusMetaType>
 
+#include <algorithm>
+#include <utility>
+
+static void rejectSubscription(const QDBusMessage &message)
+{
+    QDBusConnection::sessionBus().send(message.createErrorReply(QDBusError::ServiceUnknown, QStringLiteral("knighttimed is exiting")));
+}
+
 KDarkLightManagerInterface::KDarkLightManagerInterface(KDarkLightManager *manager, QObject *parent)
     : QObject(parent)
     , m_manager(manager)
     , m_serviceWatcher(new QDBusServiceWatcher(this))
+    , m_refreshTimer(new QTimer(this))
+    , m_admissionTimer(new QTimer(this))
+    , m_leaseTimer(new QTimer(this))
+    , m_scheduleFile(KDarkLightScheduleFile::create(KDarkLightScheduleFile::defaultFileName()))
 {
     qDBusRegisterMetaType<KNightTimeDbusCycle>();
     qDBusRegisterMetaType<QList<KNightTimeDbusCycle>>();
     qDBusRegisterMetaType<KNightTimeDbusSchedule>();
+    qDBusRegisterMetaType<KNightTimeDbusTransition>();
+    qDBusRegisterMetaType<QList<KNightTimeDbusTransition>>();
 
     connect(m_manager, &KDarkLightManager::scheduleChanged, this, &KDarkLightManagerInterface::OnScheduleChanged);
+    connect(m_manager, &KDarkLightManager::scheduleAccurateChanged, this, &KDarkLightManagerInterface::OnScheduleAccurateChanged);
+
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(std::chrono::seconds(1));
+    connect(m_refreshTimer, &QTimer::timeout, this, &KDarkLightManagerInterface::refresh);
+
+    m_admissionTimer->setSingleShot(true);
+    m_admissionTimer->setInterval(0);
+    connect(m_admissionTimer, &QTimer::timeout, this, &KDarkLightManagerInterface::admit);
+
+    m_leaseTimer->setSingleShot(true);
+    connect(m_leaseTimer, &QTimer::timeout, this, &KDarkLightManagerInterface::pruneLeases);
 
     m_serviceWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
     connect(m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &KDarkLightManagerInterface::OnServiceUnregistered);
@@ -29,59 +56,514 @@ KDarkLightManagerInterface::KDarkLightManagerInterface(KDarkLightManager *manage
     QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/NightTime/Manager"), this, QDBusConnection::ExportScriptableContents);
 }
 
+KDarkLightManagerInterface::~KDarkLightManagerInterface()
+{
+}
+
 uint KDarkLightManagerInterface::version() const
 {
-    return 1;
+    // Version 2 added GetTransitions(), RefreshedCycles() and the TypedRefreshed and
+    // WaitForAccurate options. Version 3 added leased subscriptions and Renew().
+    return 3;
+}
+
+uint KDarkLightManagerInterface::subscriberCount() const
+{
+    return m_subscribers.size();
+}
+
+uint KDarkLightManagerInterface::pendingSubscriptionCount() const
+{
+    return m_pendingSubscriptions.size() + m_admissionQueue.size();
+}
+
+uint KDarkLightManagerInterface::subscribedServiceCount() const
+{
+    return m_serviceWatcher->watchedServices().size();
+}
+
+uint KDarkLightManagerInterface::leaseCount() const
+{
+    return m_leaseIndex.size();
+}
+
+void KDarkLightManagerInterface::setLeaseDuration(std::chrono::seconds duration)
+{
+    if (m_leaseDuration == duration) {
+        return;
+    }
+
+    // If the leases have become shorter, the existing ones are cut to the new duration too. That
+    // keeps the queue ordered by the deadline, and the new leases cannot expire before the old ones.
+    if (duration < m_leaseDuration) {
+        const auto maxDeadline = std::chrono::steady_clock::now() + duration;
+        for (Lease &lease : m_leases) {
+            lease.deadline = std::min(lease.deadline, maxDeadline);
+        }
+
+        m_leaseTimer->stop();
+        schedulePruneLeases();
+    }
+    m_leaseDuration = duration;
+}
+
+void KDarkLightManagerInterface::setRefreshCoalescingInterval(std::chrono::milliseconds interval)
+{
+    m_refreshTimer->setInterval(interval);
+
+    // Do not keep subscribers waiting if coalescing has been turned off.
+    if (interval == std::chrono::milliseconds::zero() && m_refreshTimer->isActive()) {
+        m_refreshTimer->stop();
+        refresh();
+    }
+}
+
+void KDarkLightManagerInterface::setRefreshPaused(bool paused)
+{
+    if (m_refreshPaused == paused) {
+        return;
+    }
+
+    m_refreshPaused = paused;
+    if (paused) {
+        if (m_refreshTimer->isActive()) {
+            m_refreshTimer->stop();
+            m_refreshPending = true;
+        }
+    } else if (std::exchange(m_refreshPending, false)) {
+        // Do not make the subscribers wait for the coalescing window, the changes are already settled.
+        refresh();
+    }
+}
+
+void KDarkLightManagerInterface::shutdown()
+{
+    m_shuttingDown = true;
+    m_admissionTimer->stop();
+    saveCache();
+
+    // The clients retry, which starts a new daemon once this one has released its name.
+    const QList<PendingSubscription> pendingSubscriptions = std::exchange(m_admissionQueue, {}) + std::exchange(m_pendingSubscriptions, {});
+    for (const PendingSubscription &pendingSubscription : pendingSubscriptions) {
+        rejectSubscription(pendingSubscription.message);
+    }
 }
 
 QVariantMap KDarkLightManagerInterface::Subscribe(const QVariantMap &options)
 {
+    // The call has been sent before the daemon released its name, but has arrived too late.
+    if (m_shuttingDown) {
+        setDelayedReply(true);
+        rejectSubscription(message());
+        return QVariantMap();
+    }
+
     const QString subscriber = message().service();
+    setDelayedReply(true);
+
+    // Forget about the request if the client goes away in the meantime.
     m_serviceWatcher->addWatchedService(subscriber);
 
+    // The client would rather wait a bit than receive a placeholder schedule and then the real one.
+    const uint waitTimeout = std::min(options.value(QStringLiteral("WaitForAccurate")).toUInt(), 20000u);
+    if (waitTimeout && !m_manager->isScheduleAccurate()) {
+        KNIGHTTIME_TRACE_INSTANT("interface", "delaySubscribe", subscriber);
+
+        const quint64 id = ++m_lastPendingSubscriptionId;
+        m_pendingSubscriptions.append(PendingSubscription{
+            .id = id,
+            .message = message(),
+            .options = options,
+        });
+        QTimer::singleShot(waitTimeout, this, [this, id]() {
+            expirePendingSubscription(id);
+        });
+        Q_EMIT subscribersChanged();
+        return QVariantMap();
+    }
+
+    // When many clients subscribe at the same time, e.g. after the daemon has been restarted, the
+    // calls are answered together after all the queued messages have been dispatched.
+    m_admissionQueue.append(PendingSubscription{
+        .id = 0,
+        .message = message(),
+        .options = options,
+    });
+    if (!m_admissionTimer->isActive()) {
+        m_admissionTimer->start();
+        Q_EMIT subscribersChanged();
+    }
+
+    return QVariantMap();
+}
+
+QVariantMap KDarkLightManagerInterface::subscribe(const QString &subscriber, const QVariantMap &options)
+{
+    KDarkLightHistogramScope metricsScope(m_manager->metrics()->subscribe);
+    KNIGHTTIME_TRACE_SCOPE("interface", "Subscribe", subscriber);
+
+    // A client receives compact Refreshed signals only if all its subscriptions can read the shared schedule.
+    const bool sharedSchedule = m_scheduleFile && options.value(QStringLiteral("SharedSchedule")).toBool();
+    if (!sharedSchedule) {
+        m_sharedScheduleSubscribers.remove(subscriber);
+    } else if (!m_subscribers.contains(subscriber)) {
+        m_sharedScheduleSubscribers.insert(subscriber);
+    }
+
+    // Likewise, the typed RefreshedCycles signal is used only if all subscriptions can handle it.
+    const bool typedRefreshed = options.value(QStringLiteral("TypedRefreshed")).toBool();
+    if (!typedRefreshed) {
+        m_typedRefreshedSubscribers.remove(subscriber);
+    } else if (!m_subscribers.contains(subscriber)) {
+        m_typedRefreshedSubscribers.insert(subscriber);
+    }
+
+    // The reply contains the latest schedule, so the pending Refreshed signal would be redundant.
+    if ((m_refreshTimer->isActive() || m_refreshPending) && !m_subscribers.contains(subscriber)) {
+        m_upToDateSubscribers.insert(subscriber);
+    }
+
     const uint cookie = m_lastCookie++;
     m_subscribers.insert(subscriber, cookie);
 
-    return QVariantMap{
+    QVariantMap results{
         {QStringLiteral("Cookie"), cookie},
-        {QStringLiteral("Schedule"), QVariant::fromValue(KNightTimeDbusSchedule::from(m_manager->schedule()))},
+        {QStringLiteral("Accurate"), m_manager->isScheduleAccurate()},
     };
+
+    if (sharedSchedule) {
+        results.insert(QStringLiteral("ScheduleFile"), m_scheduleFile->fileName());
+        results.insert(QStringLiteral("Generation"), qulonglong(scheduleGeneration()));
+    } else {
+        results.insert(QStringLiteral("Schedule"), scheduleArgument());
+    }
+
+    // A leased subscription goes away if the client stops renewing it, even if it keeps running.
+    if (options.value(QStringLiteral("Lease")).toBool()) {
+        m_leaseIndex.insert(cookie, m_leases.insert(m_leases.end(), Lease{
+            .cookie = cookie,
+            .subscriber = subscriber,
+            .deadline = std::chrono::steady_clock::now() + m_leaseDuration,
+        }));
+        schedulePruneLeases();
+
+        results.insert(QStringLiteral("LeaseDuration"), uint(m_leaseDuration.count()));
+    }
+
+    return results;
+}
+
+void KDarkLightManagerInterface::admit()
+{
+    KNIGHTTIME_TRACE_SCOPE("interface", "admit");
+    m_manager->metrics()->subscribeBatches++;
+
+    finishPendingSubscriptions(std::exchange(m_admissionQueue, {}));
+}
+
+void KDarkLightManagerInterface::expirePendingSubscription(quint64 id)
+{
+    const auto it = std::ranges::find(m_pendingSubscriptions, id, &PendingSubscription::id);
+    if (it == m_pendingSubscriptions.end()) {
+        return;
+    }
+
+    const PendingSubscription pendingSubscription = *it;
+    m_pendingSubscriptions.erase(it);
+    finishPendingSubscriptions({pendingSubscription});
+}
+
+void KDarkLightManagerInterface::finishPendingSubscriptions(const QList<PendingSubscription> &pendingSubscriptions)
+{
+    if (pendingSubscriptions.isEmpty()) {
+        return;
+    }
+
+    for (const PendingSubscription &pendingSubscription : pendingSubscriptions) {
+        const QVariantMap results = subscribe(pendingSubscription.message.service(), pendingSubscription.options);
+        QDBusConnection::sessionBus().send(pendingSubscription.message.createReply(results));
+    }
+
+    Q_EMIT subscribersChanged();
+}
+
+void KDarkLightManagerInterface::OnScheduleAccurateChanged()
+{
+    if (m_manager->isScheduleAccurate()) {
+        finishPendingSubscriptions(std::exchange(m_pendingSubscriptions, {}));
+    }
 }
 
 void KDarkLightManagerInterface::Unsubscribe(uint cookie)
 {
+    m_manager->metrics()->unsubscribeCalls++;
+
     const QString subscriber = message().service();
+    KNIGHTTIME_TRACE_SCOPE("interface", "Unsubscribe", subscriber);
+    if (removeSubscription(subscriber, cookie)) {
+        Q_EMIT subscribersChanged();
+    }
+}
+
+bool KDarkLightManagerInterface::Renew(uint cookie)
+{
+    const auto it = m_leaseIndex.constFind(cookie);
+    if (it == m_leaseIndex.constEnd() || (*it)->subscriber != message().service()) {
+        return false;
+    }
+
+    m_manager->metrics()->leaseRenewals++;
+
+    // All leases have the same duration, so the renewed one simply moves to the back of the queue.
+    const auto lease = *it;
+    lease->deadline = std::chrono::steady_clock::now() + m_leaseDuration;
+    m_leases.splice(m_leases.end(), m_leases, lease);
+
+    return true;
+}
+
+bool KDarkLightManagerInterface::removeSubscription(const QString &subscriber, uint cookie)
+{
     if (!m_subscribers.remove(subscriber, cookie)) {
-        return;
+        return false;
     }
 
+    removeLease(cookie);
+
     if (!m_subscribers.contains(subscriber)) {
-        m_serviceWatcher->removeWatchedService(subscriber);
+        // Keep watching the client if it still has Subscribe() calls in flight.
+        const auto isFromSubscriber = [&subscriber](const PendingSubscription &pendingSubscription) {
+            return pendingSubscription.message.service() == subscriber;
+        };
+        if (std::ranges::none_of(m_pendingSubscriptions, isFromSubscriber) && std::ranges::none_of(m_admissionQueue, isFromSubscriber)) {
+            m_serviceWatcher->removeWatchedService(subscriber);
+        }
+        m_sharedScheduleSubscribers.remove(subscriber);
+        m_typedRefreshedSubscribers.remove(subscriber);
+        m_upToDateSubscribers.remove(subscriber);
+    }
+
+    return true;
+}
+
+void KDarkLightManagerInterface::removeLease(uint cookie)
+{
+    if (const auto it = m_leaseIndex.constFind(cookie); it != m_leaseIndex.constEnd()) {
+        m_leases.erase(*it);
+        m_leaseIndex.erase(it);
+    }
+}
+
+void KDarkLightManagerInterface::pruneLeases()
+{
+    KNIGHTTIME_TRACE_SCOPE("interface", "pruneLeases");
+
+    // The queue is ordered by the deadline, so only the expired leases are visited.
+    const auto now = std::chrono::steady_clock::now();
+    quint64 expiredLeases = 0;
+    while (!m_leases.empty() && m_leases.front().deadline <= now) {
+        const Lease lease = std::move(m_leases.front());
+        m_leases.pop_front();
+        m_leaseIndex.remove(lease.cookie);
+
+        removeSubscription(lease.subscriber, lease.cookie);
+        ++expiredLeases;
+    }
+
+    if (expiredLeases) {
+        m_manager->metrics()->expiredLeases += expiredLeases;
+        Q_EMIT subscribersChanged();
+    }
+
+    schedulePruneLeases();
+}
+
+void KDarkLightManagerInterface::schedulePruneLeases()
+{
+    if (m_leases.empty() || m_leaseTimer->isActive()) {
+        return;
+    }
+
+    const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(m_leases.front().deadline - std::chrono::steady_clock::now());
+    m_leaseTimer->start(std::max(timeout, std::chrono::milliseconds::zero()));
+}
+
+QList<KNightTimeDbusTransition> KDarkLightManagerInterface::GetTransitions(qint64 from, qint64 to)
+{
+    KNIGHTTIME_TRACE_SCOPE("interface", "GetTransitions", message().service());
+
+    if (from >= to) {
+        sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("The end of the window must come after its start"));
+        return {};
     }
+
+    QList<KNightTimeDbusTransition> transitions;
+    const QList<KDarkLightCycle> cycles = m_manager->schedule().cycles();
+    for (const KDarkLightCycle &cycle : cycles) {
+        for (const KDarkLightTransition &transition : {cycle.morning(), cycle.evening()}) {
+            if (transition.endDateTime().toMSecsSinceEpoch() > from && transition.startDateTime().toMSecsSinceEpoch() < to) {
+                transitions.append(KNightTimeDbusTransition::from(transition));
+            }
+        }
+    }
+
+    return transitions;
 }
 
 void KDarkLightManagerInterface::OnServiceUnregistered(const QString &serviceName)
 {
+    KNIGHTTIME_TRACE_INSTANT("interface", "serviceUnregistered", serviceName);
     m_serviceWatcher->removeWatchedService(serviceName);
-    m_subscribers.remove(serviceName);
+    for (const uint cookie : m_subscribers.values(serviceName)) {
+        removeLease(cookie);
+    }
+    m_sharedScheduleSubscribers.remove(serviceName);
+    m_typedRefreshedSubscribers.remove(serviceName);
+    m_upToDateSubscribers.remove(serviceName);
+    const auto isFromService = [&serviceName](const PendingSubscription &pendingSubscription) {
+        return pendingSubscription.message.service() == serviceName;
+    };
+    const bool hadPendingSubscriptions = m_pendingSubscriptions.removeIf(isFromService) + m_admissionQueue.removeIf(isFromService);
+    if (m_subscribers.remove(serviceName) || hadPendingSubscriptions) {
+        Q_EMIT subscribersChanged();
+    }
+}
+
+QVariant KDarkLightManagerInterface::scheduleArgument()
+{
+    // The marshalled schedule is shared between all Subscribe() replies and Refreshed signals
+    // until the schedule changes, so a burst of subscribers costs only one conversion.
+    if (!m_scheduleArgument.isValid()) {
+        KNIGHTTIME_TRACE_SCOPE("interface", "marshal");
+        const KDarkLightSchedule schedule = m_manager->schedule();
+        m_scheduleArgument = QVariant::fromValue(KNightTimeDbusSchedule::from(schedule));
+        // Only an estimate, the marshalled message also carries the header, the signature and padding.
+        m_scheduleArgumentSize = schedule.cycles().size() * sizeof(KNightTimeDbusCycle);
+    }
+    return m_scheduleArgument;
+}
+
+quint64 KDarkLightManagerInterface::scheduleGeneration()
+{
+    if (!m_scheduleGeneration) {
+        KNIGHTTIME_TRACE_SCOPE("interface", "publish");
+        m_scheduleGeneration = m_scheduleFile->publish(m_manager->schedule());
+    }
+    return m_scheduleGeneration;
 }
 
 void KDarkLightManagerInterface::OnScheduleChanged()
 {
-    const auto subscribers = m_serviceWatcher->watchedServices();
+    m_scheduleArgument = QVariant();
+    m_scheduleGeneration = 0;
+    m_upToDateSubscribers.clear();
+
+    // The shared schedule is kept up to date even if there are no subscribers.
+    if (m_scheduleFile) {
+        scheduleGeneration();
+    }
+
+    // The cache file is written together with the Refreshed signals, once per burst of changes.
+    m_cacheOutdated = true;
+
+    // The schedule can change several times in a row, e.g. at login the config is loaded and then
+    // the first position fix arrives. The subscribers are notified only once at the end of such a
+    // burst, except for the first schedule, which nobody should wait for. Subscribe() replies are
+    // always up to date.
+    if (m_refreshPaused) {
+        if (m_refreshPending) {
+            m_manager->metrics()->coalescedRefreshes++;
+        }
+        m_published = true;
+        m_refreshPending = true;
+    } else if (!m_published || m_refreshTimer->interval() == 0) {
+        m_published = true;
+        refresh();
+    } else if (m_refreshTimer->isActive()) {
+        m_manager->metrics()->coalescedRefreshes++;
+    } else {
+        m_refreshTimer->start();
+    }
+}
+
+void KDarkLightManagerInterface::saveCache()
+{
+    if (!std::exchange(m_cacheOutdated, false)) {
+        return;
+    }
+
+    // Applications that start later begin with this schedule, even if the daemon is not running.
+    KNIGHTTIME_TRACE_SCOPE("interface", "saveCache");
+    KDarkLightScheduleFile::save(KDarkLightScheduleFile::cacheFileName(), m_manager->schedule());
+}
+
+void KDarkLightManagerInterface::refresh()
+{
+    saveCache();
+
+    // Skip the clients that still wait for the Subscribe() reply or have got the latest schedule in it.
+    QStringList subscribers = m_serviceWatcher->watchedServices();
+    subscribers.removeIf([this](const QString &subscriber) {
+        return !m_subscribers.contains(subscriber) || m_upToDateSubscribers.contains(subscriber);
+    });
+    m_upToDateSubscribers.clear();
+
     if (subscribers.isEmpty()) {
         return;
     }
 
-    const QVariantMap data{
-        {QStringLiteral("Schedule"), QVariant::fromValue(KNightTimeDbusSchedule::from(m_manager->schedule()))},
-    };
+    KDarkLightHistogramScope metricsScope(m_manager->metrics()->refresh);
+    KNIGHTTIME_TRACE_SCOPE("interface", "refresh");
+
+    // The payloads are built only if somebody needs them.
+    QVariantMap data;
+    QVariant cycles;
+    quint64 cyclesSize = 0;
+    for (const QString &subscriber : subscribers) {
+        if (m_sharedScheduleSubscribers.contains(subscriber)) {
+            continue;
+        }
+        if (m_typedRefreshedSubscribers.contains(subscriber)) {
+            if (!cycles.isValid()) {
+                const QList<KNightTimeDbusCycle> dbusCycles = KNightTimeDbusCycle::fromSchedule(m_manager->schedule());
+                cycles = QVariant::fromValue(dbusCycles);
+                cyclesSize = dbusCycles.size() * sizeof(KNightTimeDbusCycle);
+            }
+        } else if (data.isEmpty()) {
+            data = QVariantMap{
+                {QStringLiteral("Schedule"), scheduleArgument()},
+            };
+        }
+    }
+
+    QVariantMap sharedData;
+    if (!m_sharedScheduleSubscribers.isEmpty()) {
+        sharedData = QVariantMap{
+            {QStringLiteral("Generation"), qulonglong(scheduleGeneration())},
+        };
+    }
 
     for (const QString &subscriber : subscribers) {
-        auto signal = QDBusMessage::createTargetedSignal(subscriber, QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Refreshed"));
-        signal.setArguments({data});
-        QDBusConnection::sessionBus().send(signal);
+        KNIGHTTIME_TRACE_SCOPE("interface", "Refreshed", subscriber);
+        if (m_sharedScheduleSubscribers.contains(subscriber)) {
+            auto signal = QDBusMessage::createTargetedSignal(subscriber, QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Refreshed"));
+            signal.setArguments({sharedData});
+            QDBusConnection::sessionBus().send(signal);
+            m_manager->metrics()->estimatedRefreshedPayloadBytes += sizeof(quint64);
+        } else if (m_typedRefreshedSubscribers.contains(subscriber)) {
+            auto signal = QDBusMessage::createTargetedSignal(subscriber, QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("RefreshedCycles"));
+            signal.setArguments({cycles});
+            QDBusConnection::sessionBus().send(signal);
+            m_manager->metrics()->estimatedRefreshedPayloadBytes += cyclesSize;
+        } else {
+            auto signal = QDBusMessage::createTargetedSignal(subscriber, QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Refreshed"));
+            signal.setArguments({data});
+            QDBusConnection::sessionBus().send(signal);
+            m_manager->metrics()->estimatedRefreshedPayloadBytes += m_scheduleArgumentSize;
+        }
     }
+
+    m_manager->metrics()->refreshedSignals += subscribers.size();
 }
 
 #include "moc_kdarklightmanagerinterface.cpp"
@@ -6,12 +6,20 @@
 
 #pragma once
 
+#include "kdarklightdbustypes_p.h"
+
 #include <QDBusContext>
+#include <QDBusMessage>
 #include <QDBusServiceWatcher>
 #include <QObject>
+#include <QSet>
+#include <QTimer>
 #include <QVariant>
 
+#include <list>
+
 class KDarkLightManager;
+class KDarkLightScheduleFile;
 
 class KDarkLightManagerInterface : public QObject, public QDBusContext
 {
@@ -21,23 +29,91 @@ class KDarkLightManagerInterface : public QObject, public QDBusContext
 
 public:
     explicit KDarkLightManagerInterface(KDarkLightManager *manager, QObject *parent = nullptr);
+    ~KDarkLightManagerInterface() override;
 
     uint version() const;
+    uint subscriberCount() const;
+    uint pendingSubscriptionCount() const;
+    uint subscribedServiceCount() const;
+    uint leaseCount() const;
+
+    void setRefreshCoalescingInterval(std::chrono::milliseconds interval);
+    void setLeaseDuration(std::chrono::seconds duration);
+    void setRefreshPaused(bool paused);
+    void shutdown();
+
+    /*
+     * Writes the current schedule to the cache file read by applications at startup, unless it is
+     * already there.
+     */
+    void saveCache();
 
 Q_SIGNALS:
     Q_SCRIPTABLE void Refreshed(const QVariantMap &data);
+    Q_SCRIPTABLE void RefreshedCycles(const QList<KNightTimeDbusCycle> &cycles);
+    void subscribersChanged();
 
 public Q_SLOTS:
     Q_SCRIPTABLE QVariantMap Subscribe(const QVariantMap &options);
     Q_SCRIPTABLE void Unsubscribe(uint cookie);
+    Q_SCRIPTABLE bool Renew(uint cookie);
+    Q_SCRIPTABLE QList<KNightTimeDbusTransition> GetTransitions(qint64 from, qint64 to);
 
 private Q_SLOTS:
     void OnScheduleChanged();
     void OnServiceUnregistered(const QString &serviceName);
+    void OnScheduleAccurateChanged();
 
 private:
+    struct PendingSubscription
+    {
+        quint64 id;
+        QDBusMessage message;
+        QVariantMap options;
+    };
+
+    struct Lease
+    {
+        uint cookie;
+        QString subscriber;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    QVariantMap subscribe(const QString &subscriber, const QVariantMap &options);
+    bool removeSubscription(const QString &subscriber, uint cookie);
+    void removeLease(uint cookie);
+    void pruneLeases();
+    void schedulePruneLeases();
+    void admit();
+    void expirePendingSubscription(quint64 id);
+    void finishPendingSubscriptions(const QList<PendingSubscription> &pendingSubscriptions);
+    void refresh();
+    QVariant scheduleArgument();
+    quint64 scheduleGeneration();
+
     KDarkLightManager *m_manager;
     QDBusServiceWatcher *m_serviceWatcher;
+    QTimer *m_refreshTimer;
+    QTimer *m_admissionTimer;
+    QTimer *m_leaseTimer;
+    bool m_published = false;
+    bool m_refreshPaused = false;
+    bool m_refreshPending = false;
+    bool m_shuttingDown = false;
+    bool m_cacheOutdated = false;
     QMultiMap<QString, uint> m_subscribers;
+    QSet<QString> m_sharedScheduleSubscribers;
+    QSet<QString> m_typedRefreshedSubscribers;
+    QSet<QString> m_upToDateSubscribers;
     uint m_lastCookie = 0;
+    QList<PendingSubscription> m_pendingSubscriptions;
+    quint64 m_lastPendingSubscriptionId = 0;
+    QList<PendingSubscription> m_admissionQueue;
+    std::chrono::seconds m_leaseDuration = std::chrono::minutes(10);
+    std::list<Lease> m_leases;
+    QHash<uint, std::list<Lease>::iterator> m_leaseIndex;
+    QVariant m_scheduleArgument;
+    quint64 m_scheduleArgumentSize = 0;
+    std::unique_ptr<KDarkLightScheduleFile> m_scheduleFile;
+    quint64 m_scheduleGeneration = 0;
 };
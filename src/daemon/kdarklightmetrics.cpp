@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kdarklightmetrics.h"
+
+#include <bit>
+
+void KDarkLightHistogram::record(std::chrono::nanoseconds duration)
+{
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    const size_t bucket = std::min<size_t>(std::bit_width(quint64(std::max<qint64>(microseconds, 0))), m_buckets.size() - 1);
+
+    m_buckets[bucket]++;
+    m_count++;
+    m_total += duration;
+    m_max = std::max(m_max, duration);
+}
+
+quint64 KDarkLightHistogram::count() const
+{
+    return m_count;
+}
+
+QVariantMap KDarkLightHistogram::toVariantMap() const
+{
+    const QList<qulonglong> buckets(m_buckets.begin(), m_buckets.end());
+    return QVariantMap{
+        {QStringLiteral("Count"), qulonglong(m_count)},
+        {QStringLiteral("TotalUsec"), qulonglong(std::chrono::duration_cast<std::chrono::microseconds>(m_total).count())},
+        {QStringLiteral("MaxUsec"), qulonglong(std::chrono::duration_cast<std::chrono::microseconds>(m_max).count())},
+        {QStringLiteral("Buckets"), QVariant::fromValue(buckets)},
+    };
+}
+
+QVariantMap KDarkLightMetrics::toVariantMap() const
+{
+    return QVariantMap{
+        {QStringLiteral("Reschedule"), reschedule.toVariantMap()},
+        {QStringLiteral("Reconfigure"), reconfigure.toVariantMap()},
+        {QStringLiteral("Subscribe"), subscribe.toVariantMap()},
+        {QStringLiteral("Refresh"), refresh.toVariantMap()},
+        {QStringLiteral("Resume"), resume.toVariantMap()},
+        {QStringLiteral("ScheduleChanges"), qulonglong(scheduleChanges)},
+        {QStringLiteral("PositionUpdatesReceived"), qulonglong(positionUpdatesReceived)},
+        {QStringLiteral("PositionUpdatesIgnored"), qulonglong(positionUpdatesIgnored)},
+        {QStringLiteral("PositionSourceStarts"), qulonglong(positionSourceStarts)},
+        {QStringLiteral("UnsubscribeCalls"), qulonglong(unsubscribeCalls)},
+        {QStringLiteral("SubscribeBatches"), qulonglong(subscribeBatches)},
+        {QStringLiteral("LeaseRenewals"), qulonglong(leaseRenewals)},
+        {QStringLiteral("ExpiredLeases"), qulonglong(expiredLeases)},
+        {QStringLiteral("Sleeps"), qulonglong(sleeps)},
+        {QStringLiteral("RefreshedSignals"), qulonglong(refreshedSignals)},
+        {QStringLiteral("CoalescedRefreshes"), qulonglong(coalescedRefreshes)},
+        {QStringLiteral("EstimatedRefreshedPayloadBytes"), qulonglong(estimatedRefreshedPayloadBytes)},
+        {QStringLiteral("StateWrites"), qulonglong(stateWrites)},
+    };
+}
@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QVariantMap>
+
+#include <array>
+#include <chrono>
+
+// Bucket i counts durations in [2^(i-1), 2^i) microseconds, the last bucket also counts everything
+// that is longer than that.
+class KDarkLightHistogram
+{
+public:
+    void record(std::chrono::nanoseconds duration);
+
+    quint64 count() const;
+    QVariantMap toVariantMap() const;
+
+private:
+    std::array<quint64, 24> m_buckets{};
+    quint64 m_count = 0;
+    std::chrono::nanoseconds m_total{0};
+    std::chrono::nanoseconds m_max{0};
+};
+
+class KDarkLightHistogramScope
+{
+public:
+    explicit KDarkLightHistogramScope(KDarkLightHistogram &histogram)
+        : m_histogram(histogram)
+    {
+        m_timer.start();
+    }
+
+    ~KDarkLightHistogramScope()
+    {
+        m_histogram.record(std::chrono::nanoseconds(m_timer.nsecsElapsed()));
+    }
+
+private:
+    KDarkLightHistogram &m_histogram;
+    QElapsedTimer m_timer;
+};
+
+struct KDarkLightMetrics
+{
+    KDarkLightHistogram reschedule;
+    KDarkLightHistogram reconfigure;
+    KDarkLightHistogram subscribe;
+    KDarkLightHistogram refresh;
+    KDarkLightHistogram resume;
+
+    quint64 scheduleChanges = 0;
+    quint64 positionUpdatesReceived = 0;
+    quint64 positionUpdatesIgnored = 0;
+    quint64 positionSourceStarts = 0;
+    quint64 unsubscribeCalls = 0;
+    quint64 subscribeBatches = 0;
+    quint64 leaseRenewals = 0;
+    quint64 expiredLeases = 0;
+    quint64 sleeps = 0;
+    quint64 refreshedSignals = 0;
+    quint64 coalescedRefreshes = 0;
+    quint64 estimatedRefreshedPayloadBytes = 0;
+    quint64 stateWrites = 0;
+
+    QVariantMap toVariantMap() const;
+};
@@ -0,0 +1,251 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kdarklightschedulecache.h"
+#include "ksolardarklightscheduler.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimeZone>
+
+#include <string_view>
+
+static const quint32 s_magic = 0x434e544b; // "KNTC"
+static const quint32 s_version = 2;
+static const int s_maxEntryCount = 32;
+static const int s_cachedCycleCount = 28;
+static const int s_cycleCount = 7;
+static const std::chrono::seconds s_maxTransitionShift(30);
+static const char s_geohashAlphabet[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+
+KDarkLightScheduleCache::KDarkLightScheduleCache(const QString &fileName)
+    : m_fileName(fileName)
+{
+    load();
+}
+
+QString KDarkLightScheduleCache::defaultFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/knighttime/schedules");
+}
+
+QByteArray KDarkLightScheduleCache::geohash(const QGeoCoordinate &coordinate, int precision)
+{
+    qreal latitudeRange[] = {-90, 90};
+    qreal longitudeRange[] = {-180, 180};
+
+    QByteArray hash;
+    hash.reserve(precision);
+
+    bool longitudeBit = true;
+    while (hash.size() < precision) {
+        int index = 0;
+        for (int bit = 0; bit < 5; ++bit) {
+            qreal *range = longitudeBit ? longitudeRange : latitudeRange;
+            const qreal value = longitudeBit ? coordinate.longitude() : coordinate.latitude();
+            const qreal middle = (range[0] + range[1]) / 2;
+            if (value >= middle) {
+                index = index * 2 + 1;
+                range[0] = middle;
+            } else {
+                index = index * 2;
+                range[1] = middle;
+            }
+            longitudeBit = !longitudeBit;
+        }
+        hash.append(s_geohashAlphabet[index]);
+    }
+
+    return hash;
+}
+
+QGeoRectangle KDarkLightScheduleCache::geohashBounds(const QByteArray &hash)
+{
+    qreal latitudeRange[] = {-90, 90};
+    qreal longitudeRange[] = {-180, 180};
+
+    bool longitudeBit = true;
+    for (const char character : hash) {
+        const int index = std::string_view(s_geohashAlphabet).find(character);
+        for (int bit = 4; bit >= 0; --bit) {
+            qreal *range = longitudeBit ? longitudeRange : latitudeRange;
+            const qreal middle = (range[0] + range[1]) / 2;
+            if (index & (1 << bit)) {
+                range[0] = middle;
+            } else {
+                range[1] = middle;
+            }
+            longitudeBit = !longitudeBit;
+        }
+    }
+
+    return QGeoRectangle(QGeoCoordinate(latitudeRange[1], longitudeRange[0]), QGeoCoordinate(latitudeRange[0], longitudeRange[1]));
+}
+
+QByteArray KDarkLightScheduleCache::cell(const QGeoCoordinate &coordinate)
+{
+    // The transitions move faster with the latitude, so the cells get smaller further from the equator:
+    // about 4.9 by 4.9 km below 55° and 1.2 by 0.6 km above.
+    return geohash(coordinate, std::abs(coordinate.latitude()) < 55 ? 5 : 6);
+}
+
+std::optional<KDarkLightSchedule> KDarkLightScheduleCache::forecast(const QDateTime &dateTime, const QGeoCoordinate &coordinate)
+{
+    // The solar forecast is made in local time, so the entries are keyed by the local date.
+    const QDateTime localDateTime = dateTime.toLocalTime();
+
+    const QByteArray cell = KDarkLightScheduleCache::cell(coordinate);
+    const QGeoCoordinate center = geohashBounds(cell).center();
+    const QByteArray timeZone = QTimeZone::systemTimeZoneId();
+
+    // The entries hold the forecast for the middle of the cell, which is not good enough close to the
+    // polar days and nights, where the transitions move quickly with the latitude, appear and disappear.
+    const auto shift = KSolarDarkLightScheduler::estimateTransitionShift(center, coordinate, localDateTime);
+    if (!shift || *shift >= s_maxTransitionShift) {
+        m_misses++;
+        return KDarkLightSchedule::forecast(localDateTime, coordinate.latitude(), coordinate.longitude(), s_cycleCount);
+    }
+
+    // The schedule starts with the cycle for the previous day.
+    const QDate firstDate = localDateTime.date().addDays(-1);
+
+    for (Entry &entry : m_entries) {
+        if (entry.cell != cell || entry.timeZone != timeZone) {
+            continue;
+        }
+
+        const qint64 offset = entry.firstDate.daysTo(firstDate);
+        if (offset >= 0 && offset + s_cycleCount + 1 <= entry.cycles.size()) {
+            m_hits++;
+            entry.lastUsed = ++m_lastUsed;
+            return KDarkLightSchedule(entry.cycles.mid(offset, s_cycleCount + 1));
+        }
+    }
+
+    m_misses++;
+
+    // Polar days and nights are not cached, the forecast for them is cheap anyway.
+    const auto schedule = KDarkLightSchedule::forecast(localDateTime, center.latitude(), center.longitude(), s_cachedCycleCount);
+    if (!schedule) {
+        return KDarkLightSchedule::forecast(localDateTime, coordinate.latitude(), coordinate.longitude(), s_cycleCount);
+    }
+
+    const QList<KDarkLightCycle> cycles = schedule->cycles();
+
+    m_entries.removeIf([&](const Entry &entry) {
+        return entry.cell == cell && entry.timeZone == timeZone;
+    });
+    if (m_entries.size() >= s_maxEntryCount) {
+        const auto leastRecentlyUsed = std::ranges::min_element(m_entries, {}, &Entry::lastUsed);
+        m_entries.erase(leastRecentlyUsed);
+    }
+    m_entries.append(Entry{
+        .cell = cell,
+        .timeZone = timeZone,
+        .firstDate = firstDate,
+        .lastUsed = ++m_lastUsed,
+        .cycles = cycles,
+    });
+    save();
+
+    return KDarkLightSchedule(cycles.mid(0, s_cycleCount + 1));
+}
+
+quint64 KDarkLightScheduleCache::hits() const
+{
+    return m_hits;
+}
+
+quint64 KDarkLightScheduleCache::misses() const
+{
+    return m_misses;
+}
+
+void KDarkLightScheduleCache::load()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic;
+    quint32 version;
+    quint32 entryCount;
+    stream >> magic >> version >> entryCount;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_version || entryCount > s_maxEntryCount) {
+        return;
+    }
+
+    QList<Entry> entries;
+    entries.reserve(entryCount);
+
+    for (quint32 i = 0; i < entryCount; ++i) {
+        Entry entry;
+        quint32 cycleCount;
+        stream >> entry.cell >> entry.timeZone >> entry.firstDate >> entry.lastUsed >> cycleCount;
+        if (stream.status() != QDataStream::Ok || cycleCount > s_cachedCycleCount + 1) {
+            return;
+        }
+
+        const QTimeZone timeZone(entry.timeZone);
+        entry.cycles.reserve(cycleCount);
+        for (quint32 j = 0; j < cycleCount; ++j) {
+            qint64 noon;
+            qint64 morningStart;
+            qint64 morningEnd;
+            qint64 eveningStart;
+            qint64 eveningEnd;
+            stream >> noon >> morningStart >> morningEnd >> eveningStart >> eveningEnd;
+
+            entry.cycles.append(KDarkLightCycle(QDateTime::fromMSecsSinceEpoch(noon, timeZone),
+                                                KDarkLightTransition(KDarkLightTransition::Morning, QDateTime::fromMSecsSinceEpoch(morningStart, timeZone), QDateTime::fromMSecsSinceEpoch(morningEnd, timeZone)),
+                                                KDarkLightTransition(KDarkLightTransition::Evening, QDateTime::fromMSecsSinceEpoch(eveningStart, timeZone), QDateTime::fromMSecsSinceEpoch(eveningEnd, timeZone))));
+        }
+
+        if (stream.status() != QDataStream::Ok) {
+            return;
+        }
+
+        m_lastUsed = std::max(m_lastUsed, entry.lastUsed);
+        entries.append(entry);
+    }
+
+    m_entries = entries;
+}
+
+void KDarkLightScheduleCache::save() const
+{
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << s_magic << s_version << quint32(m_entries.size());
+
+    for (const Entry &entry : m_entries) {
+        stream << entry.cell << entry.timeZone << entry.firstDate << entry.lastUsed << quint32(entry.cycles.size());
+        for (const KDarkLightCycle &cycle : entry.cycles) {
+            stream << cycle.noonDateTime().toMSecsSinceEpoch() //
+                   << cycle.morning().startDateTime().toMSecsSinceEpoch() //
+                   << cycle.morning().endDateTime().toMSecsSinceEpoch() //
+                   << cycle.evening().startDateTime().toMSecsSinceEpoch() //
+                   << cycle.evening().endDateTime().toMSecsSinceEpoch();
+        }
+    }
+
+    file.commit();
+}
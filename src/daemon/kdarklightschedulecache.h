@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "kdarklightschedule.h"
+
+#include <QGeoCoordinate>
+#include <QGeoRectangle>
+
+/*
+ * The KDarkLightScheduleCache keeps solar forecasts for recently visited places on disk, so the
+ * schedule for a known location can be looked up rather than computed from scratch.
+ *
+ * Locations are quantized to geohash cells that are a few kilometers wide or less, depending on the
+ * latitude, and the forecast is made for the middle of the cell. If the transitions at the requested
+ * location are estimated to be 30 seconds or more away from those in the middle of its cell, e.g.
+ * close to the polar days and nights, the forecast is computed from scratch. Every entry covers a
+ * few weeks, and the least recently used entries are evicted when the cache is full.
+ */
+class KDarkLightScheduleCache
+{
+public:
+    explicit KDarkLightScheduleCache(const QString &fileName);
+
+    static QString defaultFileName();
+    static QByteArray geohash(const QGeoCoordinate &coordinate, int precision);
+    static QGeoRectangle geohashBounds(const QByteArray &hash);
+    static QByteArray cell(const QGeoCoordinate &coordinate);
+
+    std::optional<KDarkLightSchedule> forecast(const QDateTime &dateTime, const QGeoCoordinate &coordinate);
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+private:
+    struct Entry
+    {
+        QByteArray cell;
+        QByteArray timeZone;
+        QDate firstDate;
+        quint64 lastUsed = 0;
+        QList<KDarkLightCycle> cycles;
+    };
+
+    void load();
+    void save() const;
+
+    QString m_fileName;
+    QList<Entry> m_entries;
+    quint64 m_lastUsed = 0;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
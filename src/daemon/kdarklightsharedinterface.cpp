@@ -0,0 +1,124 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kdarklightsharedinterface.h"
+#include "knighttimetrace_p.h"
+#include "ksolardarklightscheduler.h"
+#include "ktimeddarklightscheduler.h"
+
+#include <QTimeZone>
+
+// Every session sends its own configuration, so a misbehaving client must not be able to make
+// the cache grow without bounds.
+static const int s_maxEntryCount = 1024;
+static const uint s_secondsInDay = 86400;
+
+KDarkLightSharedInterface::KDarkLightSharedInterface(const QDBusConnection &connection, QObject *parent)
+    : QObject(parent)
+{
+    QDBusConnection(connection).registerObject(QStringLiteral("/org/kde/NightTime/Shared"), this, QDBusConnection::ExportScriptableContents);
+}
+
+KDarkLightSharedInterface::~KDarkLightSharedInterface()
+{
+}
+
+uint KDarkLightSharedInterface::configurationCount() const
+{
+    return m_entries.size();
+}
+
+qulonglong KDarkLightSharedInterface::requestCount() const
+{
+    return m_requestCount;
+}
+
+qulonglong KDarkLightSharedInterface::computationCount() const
+{
+    return m_computationCount;
+}
+
+QString KDarkLightSharedInterface::GetSchedule(const QVariantMap &configuration, qint64 referenceTime)
+{
+    KNIGHTTIME_TRACE_SCOPE("shared", "getSchedule");
+    m_requestCount++;
+
+    const QByteArray timeZoneId = configuration.value(QStringLiteral("TimeZone")).toString().toLatin1();
+    const QTimeZone timeZone(timeZoneId);
+    if (!timeZone.isValid()) {
+        sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Unknown time zone"));
+        return QString();
+    }
+
+    QString key;
+    std::unique_ptr<KDarkLightScheduler> scheduler;
+
+    const QString source = configuration.value(QStringLiteral("Source")).toString();
+    if (source == QLatin1String("Location")) {
+        bool latitudeOk = false;
+        bool longitudeOk = false;
+        const qreal latitude = configuration.value(QStringLiteral("Latitude")).toDouble(&latitudeOk);
+        const qreal longitude = configuration.value(QStringLiteral("Longitude")).toDouble(&longitudeOk);
+        const QGeoCoordinate coordinate(latitude, longitude);
+        if (!latitudeOk || !longitudeOk || !coordinate.isValid()) {
+            sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Invalid location"));
+            return QString();
+        }
+
+        key = QLatin1String("location ") + QString::fromLatin1(timeZoneId) + QLatin1Char(' ') + QString::number(latitude, 'g', 17) + QLatin1Char(' ') + QString::number(longitude, 'g', 17);
+        scheduler = std::make_unique<KSolarDarkLightScheduler>(coordinate);
+    } else if (source == QLatin1String("Times")) {
+        // The timed forecast is computed in the local time of this process.
+        if (timeZoneId != QTimeZone::systemTimeZoneId()) {
+            sendErrorReply(QStringLiteral("org.kde.NightTime.Error.TimeZone"), QStringLiteral("The times can be shared only in the system time zone"));
+            return QString();
+        }
+
+        const uint sunriseStart = configuration.value(QStringLiteral("SunriseStart")).toUInt();
+        const uint sunsetStart = configuration.value(QStringLiteral("SunsetStart")).toUInt();
+        const uint transitionDuration = configuration.value(QStringLiteral("TransitionDuration")).toUInt();
+        if (sunriseStart >= s_secondsInDay || sunsetStart >= s_secondsInDay || transitionDuration >= s_secondsInDay) {
+            sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Invalid times"));
+            return QString();
+        }
+
+        key = QStringLiteral("times %1 %2 %3").arg(sunriseStart).arg(sunsetStart).arg(transitionDuration);
+        scheduler = std::make_unique<KTimedDarkLightScheduler>(QTime::fromMSecsSinceStartOfDay(sunriseStart * 1000), QTime::fromMSecsSinceStartOfDay(sunsetStart * 1000), transitionDuration);
+    } else {
+        sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Unknown source"));
+        return QString();
+    }
+
+    // The forecasts depend only on the date, so the sessions can share a schedule for the whole day.
+    const QDateTime referenceDateTime = QDateTime::fromMSecsSinceEpoch(referenceTime, timeZone);
+    const QDate date = referenceDateTime.date();
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->date == date) {
+        return it->state;
+    }
+
+    if (it == m_entries.end() && m_entries.size() >= s_maxEntryCount) {
+        m_entries.removeIf([&date](const std::pair<const QString &, Entry &> &entry) {
+            return entry.second.date != date;
+        });
+        if (m_entries.size() >= s_maxEntryCount) {
+            m_entries.clear();
+        }
+    }
+
+    KNIGHTTIME_TRACE_SCOPE("shared", "forecast");
+    m_computationCount++;
+
+    const QString state = scheduler->schedule(referenceDateTime).toState();
+    m_entries.insert(key, Entry{
+                              .date = date,
+                              .state = state,
+                          });
+    return state;
+}
+
+#include "moc_kdarklightsharedinterface.cpp"
@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QDate>
+#include <QHash>
+#include <QObject>
+#include <QVariant>
+
+/*
+ * The KDarkLightSharedInterface is served by the system-wide instance of knighttimed. It computes
+ * the schedule once per distinct configuration and day, so the per-session daemons on the same
+ * machine only need to forward their settings.
+ */
+class KDarkLightSharedInterface : public QObject, public QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.NightTime.Shared")
+    Q_PROPERTY(uint Configurations READ configurationCount)
+    Q_PROPERTY(qulonglong Requests READ requestCount)
+    Q_PROPERTY(qulonglong Computations READ computationCount)
+
+public:
+    explicit KDarkLightSharedInterface(const QDBusConnection &connection, QObject *parent = nullptr);
+    ~KDarkLightSharedInterface() override;
+
+    uint configurationCount() const;
+    qulonglong requestCount() const;
+    qulonglong computationCount() const;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString GetSchedule(const QVariantMap &configuration, qint64 referenceTime);
+
+private:
+    struct Entry
+    {
+        QDate date;
+        QString state;
+    };
+
+    QHash<QString, Entry> m_entries;
+    quint64 m_requestCount = 0;
+    quint64 m_computationCount = 0;
+};
@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kpositionupdatecontroller.h"
+
+using namespace std::chrono_literals;
+
+// At 90 km/h, the transitions can move by a minute in about a quarter of an hour.
+static const qreal fastSpeed = 25;
+static const std::chrono::milliseconds fastInterval = 1min;
+static const std::chrono::milliseconds movingInterval = 5min;
+static const std::chrono::milliseconds maximumTrackingInterval = 30min;
+static const std::chrono::milliseconds minimumRequestInterval = 1h;
+static const std::chrono::milliseconds maximumRequestInterval = 6h;
+static const qreal minimumStationaryRadius = 500;
+static const int stationaryUpdatesToSettle = 3;
+
+static qreal stationaryRadius(const QGeoPositionInfo &update)
+{
+    if (update.hasAttribute(QGeoPositionInfo::HorizontalAccuracy)) {
+        return std::max(minimumStationaryRadius, 2 * update.attribute(QGeoPositionInfo::HorizontalAccuracy));
+    }
+    return minimumStationaryRadius;
+}
+
+static qreal groundSpeed(const QGeoPositionInfo &previous, const QGeoPositionInfo &current)
+{
+    if (current.hasAttribute(QGeoPositionInfo::GroundSpeed)) {
+        return current.attribute(QGeoPositionInfo::GroundSpeed);
+    }
+
+    const qint64 elapsed = previous.timestamp().msecsTo(current.timestamp());
+    if (elapsed <= 0) {
+        return 0;
+    }
+    return previous.coordinate().distanceTo(current.coordinate()) * 1000 / elapsed;
+}
+
+KPositionUpdateController::KPositionUpdateController(QGeoPositionInfoSource *source, KNightTimeClock *clock, QObject *parent)
+    : QObject(parent)
+    , m_source(source)
+    , m_requestTimer(clock->createTimer())
+    , m_interval(movingInterval)
+{
+    connect(m_source, &QGeoPositionInfoSource::positionUpdated, this, &KPositionUpdateController::positionUpdated);
+    connect(m_source, &QGeoPositionInfoSource::errorOccurred, this, &KPositionUpdateController::errorOccurred);
+    connect(m_requestTimer.get(), &KNightTimeTimer::timeout, m_source, [this]() {
+        m_source->requestUpdate();
+    });
+}
+
+KPositionUpdateController::~KPositionUpdateController()
+{
+}
+
+void KPositionUpdateController::start()
+{
+    track(movingInterval);
+}
+
+bool KPositionUpdateController::isStationary() const
+{
+    return m_stationary;
+}
+
+std::chrono::milliseconds KPositionUpdateController::interval() const
+{
+    return m_interval;
+}
+
+void KPositionUpdateController::track(std::chrono::milliseconds interval)
+{
+    m_interval = interval;
+    m_source->setUpdateInterval(interval.count());
+
+    if (m_stationary) {
+        m_stationary = false;
+        m_requestTimer->stop();
+    }
+    m_source->startUpdates();
+}
+
+void KPositionUpdateController::settle(std::chrono::milliseconds interval)
+{
+    m_interval = interval;
+
+    if (!m_stationary) {
+        m_stationary = true;
+        m_source->stopUpdates();
+    }
+    m_requestTimer->start(interval);
+}
+
+void KPositionUpdateController::positionUpdated(const QGeoPositionInfo &update)
+{
+    const QGeoPositionInfo previous = std::exchange(m_lastPosition, update);
+    if (!m_anchor.isValid()) {
+        m_anchor = update;
+        return;
+    }
+
+    const bool moved = m_anchor.coordinate().distanceTo(update.coordinate()) > stationaryRadius(update);
+    if (moved) {
+        m_anchor = update;
+        m_stationaryUpdates = 0;
+
+        // The speed cannot be estimated from one-shot updates, they are too far apart.
+        const qreal speed = m_stationary ? 0 : groundSpeed(previous, update);
+        const std::chrono::milliseconds interval = speed >= fastSpeed ? fastInterval : movingInterval;
+        if (m_stationary || m_interval != interval) {
+            track(interval);
+        }
+        return;
+    }
+
+    if (m_stationary) {
+        settle(std::min(m_interval * 2, maximumRequestInterval));
+    } else if (++m_stationaryUpdates >= stationaryUpdatesToSettle) {
+        settle(minimumRequestInterval);
+    } else {
+        track(std::min(m_interval * 2, maximumTrackingInterval));
+    }
+}
+
+void KPositionUpdateController::errorOccurred(QGeoPositionInfoSource::Error error)
+{
+    // A one-shot request has not been answered, try again later.
+    if (m_stationary && error == QGeoPositionInfoSource::UpdateTimeoutError) {
+        m_requestTimer->start(m_interval);
+    }
+}
+
+#include "moc_kpositionupdatecontroller.cpp"
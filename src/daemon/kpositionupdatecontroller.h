@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "knighttimeclock_p.h"
+
+#include <QGeoPositionInfoSource>
+
+/*
+ * The KPositionUpdateController adjusts how often the position source is polled. The update interval
+ * is reduced while the device moves fast and increased while it stays at the same place. Once the
+ * device looks stationary, continuous updates are stopped and the position is only checked with
+ * occasional one-shot requests.
+ */
+class KPositionUpdateController : public QObject
+{
+    Q_OBJECT
+
+public:
+    KPositionUpdateController(QGeoPositionInfoSource *source, KNightTimeClock *clock, QObject *parent = nullptr);
+    ~KPositionUpdateController() override;
+
+    void start();
+
+    bool isStationary() const;
+    std::chrono::milliseconds interval() const;
+
+private:
+    void positionUpdated(const QGeoPositionInfo &update);
+    void errorOccurred(QGeoPositionInfoSource::Error error);
+    void track(std::chrono::milliseconds interval);
+    void settle(std::chrono::milliseconds interval);
+
+    QGeoPositionInfoSource *m_source;
+    std::unique_ptr<KNightTimeTimer> m_requestTimer;
+    QGeoPositionInfo m_anchor;
+    QGeoPositionInfo m_lastPosition;
+    std::chrono::milliseconds m_interval;
+    int m_stationaryUpdates = 0;
+    bool m_stationary = false;
+};
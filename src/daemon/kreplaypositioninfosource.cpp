@@ -0,0 +1,207 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kreplaypositioninfosource.h"
+
+#include <QFile>
+#include <QTimeZone>
+
+static std::optional<qreal> parseNmeaAngle(const QByteArray &value, const QByteArray &hemisphere)
+{
+    // The angle is encoded as [d]ddmm.mmmm
+    bool ok;
+    const qreal raw = value.toDouble(&ok);
+    if (!ok) {
+        return std::nullopt;
+    }
+
+    const qreal degrees = std::floor(raw / 100);
+    const qreal angle = degrees + (raw - degrees * 100) / 60;
+    if (hemisphere == "S" || hemisphere == "W") {
+        return -angle;
+    }
+    return angle;
+}
+
+static std::optional<QGeoPositionInfo> parseNmeaSentence(QByteArray sentence)
+{
+    sentence = sentence.trimmed();
+    if (!sentence.startsWith('$')) {
+        return std::nullopt;
+    }
+
+    if (const qsizetype checksumIndex = sentence.indexOf('*'); checksumIndex != -1) {
+        quint8 checksum = 0;
+        for (qsizetype i = 1; i < checksumIndex; ++i) {
+            checksum ^= quint8(sentence[i]);
+        }
+
+        bool ok;
+        if (sentence.mid(checksumIndex + 1).toUInt(&ok, 16) != checksum || !ok) {
+            return std::nullopt;
+        }
+        sentence.truncate(checksumIndex);
+    }
+
+    const QList<QByteArray> fields = sentence.split(',');
+    if (fields.size() < 10 || !fields[0].endsWith("RMC")) {
+        return std::nullopt;
+    }
+
+    const QTime time = QTime::fromString(QString::fromLatin1(fields[1].left(6)), QStringLiteral("hhmmss"));
+    const QDate date = QDate::fromString(QString::fromLatin1(fields[9]), QStringLiteral("ddMMyy")).addYears(100);
+    if (!time.isValid() || !date.isValid()) {
+        return std::nullopt;
+    }
+
+    // The receiver has no fix yet, only the time is known.
+    if (fields[2] != "A") {
+        return QGeoPositionInfo(QGeoCoordinate(), QDateTime(date, time, QTimeZone::UTC));
+    }
+
+    const auto latitude = parseNmeaAngle(fields[3], fields[4]);
+    const auto longitude = parseNmeaAngle(fields[5], fields[6]);
+    if (!latitude || !longitude) {
+        return std::nullopt;
+    }
+
+    return QGeoPositionInfo(QGeoCoordinate(*latitude, *longitude), QDateTime(date, time, QTimeZone::UTC));
+}
+
+KReplayPositionInfoSource::KReplayPositionInfoSource(const QString &fileName, qreal speed, KNightTimeClock *clock, QObject *parent)
+    : QGeoPositionInfoSource(parent)
+    , m_clock(clock)
+    , m_timer(clock->createTimer())
+    , m_startDateTime(clock->currentDateTime())
+    , m_speed(speed)
+{
+    connect(m_timer.get(), &KNightTimeTimer::timeout, this, &KReplayPositionInfoSource::replayNext);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = AccessError;
+        return;
+    }
+
+    while (!file.atEnd()) {
+        if (const auto position = parseNmeaSentence(file.readLine())) {
+            // The sentences without a fix tell how long it takes to acquire the first one.
+            if (!m_replayStartDateTime.isValid()) {
+                m_replayStartDateTime = position->timestamp();
+            }
+            if (position->coordinate().isValid()) {
+                m_positions.append(*position);
+            }
+        }
+    }
+}
+
+QGeoPositionInfo KReplayPositionInfoSource::lastKnownPosition(bool fromSatellitePositioningMethodsOnly) const
+{
+    return m_lastKnownPosition;
+}
+
+QGeoPositionInfoSource::PositioningMethods KReplayPositionInfoSource::supportedPositioningMethods() const
+{
+    return SatellitePositioningMethods;
+}
+
+int KReplayPositionInfoSource::minimumUpdateInterval() const
+{
+    return 0;
+}
+
+QGeoPositionInfoSource::Error KReplayPositionInfoSource::error() const
+{
+    return m_error;
+}
+
+void KReplayPositionInfoSource::startUpdates()
+{
+    if (m_error != NoError) {
+        QMetaObject::invokeMethod(this, &KReplayPositionInfoSource::errorOccurred, Qt::QueuedConnection, m_error);
+        return;
+    }
+
+    m_active = true;
+    scheduleNext();
+}
+
+void KReplayPositionInfoSource::stopUpdates()
+{
+    m_active = false;
+    if (!m_updateRequested) {
+        m_timer->stop();
+    }
+}
+
+void KReplayPositionInfoSource::requestUpdate(int timeout)
+{
+    if (m_error != NoError) {
+        QMetaObject::invokeMethod(this, &KReplayPositionInfoSource::errorOccurred, Qt::QueuedConnection, m_error);
+        return;
+    }
+
+    m_updateRequested = true;
+    scheduleNext();
+}
+
+QDateTime KReplayPositionInfoSource::replayDateTime() const
+{
+    const qint64 elapsed = m_startDateTime.msecsTo(m_clock->currentDateTime());
+    return m_replayStartDateTime.addMSecs(qint64(elapsed * m_speed));
+}
+
+void KReplayPositionInfoSource::scheduleNext()
+{
+    if (m_timer->isActive()) {
+        return;
+    }
+
+    // When the log is played along the clock, the positions recorded in the past are gone.
+    if (m_speed > 0 && !m_positions.isEmpty()) {
+        const QDateTime now = replayDateTime();
+        while (m_nextPosition + 1 < m_positions.size() && m_positions[m_nextPosition + 1].timestamp() <= now) {
+            ++m_nextPosition;
+        }
+    }
+
+    // Positions that would not be reported with the current update interval are skipped, so the
+    // replay behaves as a device that is polled at that interval.
+    if (m_lastKnownPosition.isValid()) {
+        const QDateTime nextTimestamp = m_lastKnownPosition.timestamp().addMSecs(updateInterval());
+        while (m_nextPosition < m_positions.size() && m_positions[m_nextPosition].timestamp() < nextTimestamp) {
+            ++m_nextPosition;
+        }
+    }
+
+    if (m_nextPosition == m_positions.size()) {
+        if (m_updateRequested) {
+            m_updateRequested = false;
+            QMetaObject::invokeMethod(this, &KReplayPositionInfoSource::errorOccurred, Qt::QueuedConnection, UpdateTimeoutError);
+        }
+        return;
+    }
+
+    std::chrono::milliseconds delay(0);
+    if (m_speed > 0) {
+        delay = std::chrono::milliseconds(std::max<qint64>(0, replayDateTime().msecsTo(m_positions[m_nextPosition].timestamp()) / m_speed));
+    }
+
+    m_timer->start(delay);
+}
+
+void KReplayPositionInfoSource::replayNext()
+{
+    m_lastKnownPosition = m_positions[m_nextPosition++];
+    m_updateRequested = false;
+
+    Q_EMIT positionUpdated(m_lastKnownPosition);
+
+    if (m_active) {
+        scheduleNext();
+    }
+}
@@ -0,0 +1,54 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "knighttimeclock_p.h"
+
+#include <QGeoPositionInfoSource>
+
+/*
+ * The KReplayPositionInfoSource replays positions recorded in an NMEA log (only RMC sentences are
+ * used, the ones without a fix only delay the first position). The time between position updates
+ * is divided by the speed factor, a speed factor of zero replays the log as fast as possible.
+ * Otherwise, the log is played along the given clock, and positions that were recorded while no
+ * updates were requested are never reported. It is used to reproduce and benchmark automatic
+ * location handling without a real positioning backend.
+ */
+class KReplayPositionInfoSource : public QGeoPositionInfoSource
+{
+    Q_OBJECT
+
+public:
+    KReplayPositionInfoSource(const QString &fileName, qreal speed, KNightTimeClock *clock = KNightTimeClock::system(), QObject *parent = nullptr);
+
+    QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const override;
+    PositioningMethods supportedPositioningMethods() const override;
+    int minimumUpdateInterval() const override;
+    Error error() const override;
+
+public Q_SLOTS:
+    void startUpdates() override;
+    void stopUpdates() override;
+    void requestUpdate(int timeout = 0) override;
+
+private:
+    QDateTime replayDateTime() const;
+    void scheduleNext();
+    void replayNext();
+
+    QList<QGeoPositionInfo> m_positions;
+    qsizetype m_nextPosition = 0;
+    QGeoPositionInfo m_lastKnownPosition;
+    KNightTimeClock *m_clock;
+    std::unique_ptr<KNightTimeTimer> m_timer;
+    QDateTime m_startDateTime;
+    QDateTime m_replayStartDateTime;
+    qreal m_speed;
+    Error m_error = NoError;
+    bool m_active = false;
+    bool m_updateRequested = false;
+};
@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "kshareddarklightscheduler.h"
+#include "knighttimetrace_p.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingReply>
+#include <QTimeZone>
+
+KSharedDarkLightScheduler::KSharedDarkLightScheduler(const QVariantMap &configuration, std::unique_ptr<KDarkLightScheduler> &&fallback)
+    : m_configuration(configuration)
+    , m_fallback(std::move(fallback))
+{
+    m_configuration[QStringLiteral("TimeZone")] = QString::fromLatin1(QTimeZone::systemTimeZoneId());
+}
+
+KSharedDarkLightScheduler::~KSharedDarkLightScheduler()
+{
+}
+
+QVariantMap KSharedDarkLightScheduler::locationConfiguration(qreal latitude, qreal longitude)
+{
+    return QVariantMap{
+        {QStringLiteral("Source"), QStringLiteral("Location")},
+        {QStringLiteral("Latitude"), latitude},
+        {QStringLiteral("Longitude"), longitude},
+    };
+}
+
+QVariantMap KSharedDarkLightScheduler::timesConfiguration(QTime sunriseStart, QTime sunsetStart, uint transitionDuration)
+{
+    return QVariantMap{
+        {QStringLiteral("Source"), QStringLiteral("Times")},
+        {QStringLiteral("SunriseStart"), uint(sunriseStart.msecsSinceStartOfDay() / 1000)},
+        {QStringLiteral("SunsetStart"), uint(sunsetStart.msecsSinceStartOfDay() / 1000)},
+        {QStringLiteral("TransitionDuration"), transitionDuration},
+    };
+}
+
+KDarkLightScheduler *KSharedDarkLightScheduler::fallback() const
+{
+    return m_fallback.get();
+}
+
+KDarkLightSchedule KSharedDarkLightScheduler::schedule(const QDateTime &referenceDateTime)
+{
+    // The system instance shares one schedule per day, see KDarkLightSharedInterface::GetSchedule().
+    const QDate date = referenceDateTime.toLocalTime().date();
+    if (m_date != date) {
+        m_date = date;
+        m_schedule.reset();
+        fetch(referenceDateTime);
+    }
+
+    if (m_schedule) {
+        return *m_schedule;
+    }
+
+    // The system instance may need to be activated first, the session must not wait for it. If the
+    // request fails, it is not sent again until the next day, the fallback schedule is the same
+    // forecast computed locally.
+    return m_fallback->schedule(referenceDateTime);
+}
+
+void KSharedDarkLightScheduler::fetch(const QDateTime &referenceDateTime)
+{
+    KNIGHTTIME_TRACE_INSTANT("sharedscheduler", "getSchedule");
+
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Shared"), QStringLiteral("org.kde.NightTime.Shared"), QStringLiteral("GetSchedule"));
+    message.setArguments({m_configuration, referenceDateTime.toMSecsSinceEpoch()});
+
+    delete m_watcher;
+    m_watcher = new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(message), this);
+    connect(m_watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        m_watcher = nullptr;
+
+        const QDBusPendingReply<QString> reply = *watcher;
+        if (reply.isError()) {
+            KNIGHTTIME_TRACE_INSTANT("sharedscheduler", "getScheduleFailed");
+            return;
+        }
+
+        if (auto schedule = KDarkLightSchedule::fromState(reply.value())) {
+            m_schedule = *schedule;
+            Q_EMIT scheduleChanged();
+        }
+    });
+}
+
+#include "moc_kshareddarklightscheduler.cpp"
@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "kdarklightscheduler.h"
+
+#include <QDBusPendingCallWatcher>
+#include <QObject>
+#include <QVariantMap>
+
+#include <memory>
+#include <optional>
+
+/*
+ * The KSharedDarkLightScheduler asks the system-wide instance of knighttimed for the schedule,
+ * see KDarkLightSharedInterface. The request is asynchronous, the schedule computed by the fallback
+ * scheduler is served until the system instance replies, and the scheduleChanged() signal is emitted
+ * once the shared schedule is available. If the system instance is not available, the fallback
+ * schedule is kept, and the system instance is asked again only for the next day.
+ */
+class KSharedDarkLightScheduler : public QObject, public KDarkLightScheduler
+{
+    Q_OBJECT
+
+public:
+    KSharedDarkLightScheduler(const QVariantMap &configuration, std::unique_ptr<KDarkLightScheduler> &&fallback);
+    ~KSharedDarkLightScheduler() override;
+
+    static QVariantMap locationConfiguration(qreal latitude, qreal longitude);
+    static QVariantMap timesConfiguration(QTime sunriseStart, QTime sunsetStart, uint transitionDuration);
+
+    KDarkLightScheduler *fallback() const;
+    KDarkLightSchedule schedule(const QDateTime &referenceDateTime) override;
+
+Q_SIGNALS:
+    void scheduleChanged();
+
+private:
+    void fetch(const QDateTime &referenceDateTime);
+
+    QVariantMap m_configuration;
+    std::unique_ptr<KDarkLightScheduler> m_fallback;
+    QDBusPendingCallWatcher *m_watcher = nullptr;
+    QDate m_date;
+    std::optional<KDarkLightSchedule> m_schedule;
+};
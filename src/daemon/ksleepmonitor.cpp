@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "ksleepmonitor.h"
+#include "knighttimetrace_p.h"
+
+#include <QDBusConnection>
+#include <QDBusServiceWatcher>
+#include <QTimer>
+
+using namespace std::chrono_literals;
+
+// The system is suspended a few seconds after the PrepareForSleep signal, once the delay locks are
+// released. The monotonic clock stands still while the system sleeps, so this is the time that the
+// system can stay awake after the signal.
+static constexpr std::chrono::milliseconds s_watchdogTimeout = 1min;
+
+KSleepMonitor::KSleepMonitor(QObject *parent)
+    : QObject(parent)
+    , m_watchdogTimer(new QTimer(this))
+{
+    // Nothing needs to be saved before the system goes to sleep, so there is no need to take
+    // a delay inhibitor lock. If the signal arrives late, it is handled after resume.
+    const bool sessionBus = qEnvironmentVariable("KNIGHTTIMED_LOGIND_BUS") == QLatin1String("session");
+    QDBusConnection bus = sessionBus ? QDBusConnection::sessionBus() : QDBusConnection::systemBus();
+    bus.connect(QStringLiteral("org.freedesktop.login1"), QStringLiteral("/org/freedesktop/login1"), QStringLiteral("org.freedesktop.login1.Manager"), QStringLiteral("PrepareForSleep"), this, SLOT(OnPrepareForSleep(bool)));
+
+    // If logind is restarted or crashes before the system resumes, the resume signal never arrives.
+    m_logindWatcher = new QDBusServiceWatcher(QStringLiteral("org.freedesktop.login1"), bus, QDBusServiceWatcher::WatchForUnregistration, this);
+    connect(m_logindWatcher, &QDBusServiceWatcher::serviceUnregistered, this, [this]() {
+        KNIGHTTIME_TRACE_INSTANT("sleepmonitor", "logindUnregistered");
+        OnPrepareForSleep(false);
+    });
+
+    m_watchdogTimer->setSingleShot(true);
+    m_watchdogTimer->setInterval(s_watchdogTimeout);
+    connect(m_watchdogTimer, &QTimer::timeout, this, [this]() {
+        KNIGHTTIME_TRACE_INSTANT("sleepmonitor", "watchdog");
+        OnPrepareForSleep(false);
+    });
+}
+
+KSleepMonitor::~KSleepMonitor()
+{
+}
+
+bool KSleepMonitor::isSleeping() const
+{
+    return m_sleeping;
+}
+
+void KSleepMonitor::OnPrepareForSleep(bool sleep)
+{
+    if (m_sleeping == sleep) {
+        return;
+    }
+
+    m_sleeping = sleep;
+    if (sleep) {
+        KNIGHTTIME_TRACE_INSTANT("sleepmonitor", "aboutToSleep");
+        m_watchdogTimer->start();
+        Q_EMIT aboutToSleep();
+    } else {
+        KNIGHTTIME_TRACE_INSTANT("sleepmonitor", "resumed");
+        m_watchdogTimer->stop();
+        Q_EMIT resumed();
+    }
+}
+
+#include "moc_ksleepmonitor.cpp"
@@ -0,0 +1,45 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QObject>
+
+class QDBusServiceWatcher;
+class QTimer;
+
+/*
+ * The KSleepMonitor watches the PrepareForSleep signal of logind and reports when the system is
+ * about to be suspended or hibernated and when it has resumed.
+ *
+ * The system is considered awake again if logind leaves the bus, or if the resume signal does not
+ * arrive within a minute of the time the system has actually been running.
+ *
+ * The session bus is watched instead of the system bus if the KNIGHTTIMED_LOGIND_BUS environment
+ * variable is set to "session", so tests can use a mock logind service.
+ */
+class KSleepMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KSleepMonitor(QObject *parent = nullptr);
+    ~KSleepMonitor() override;
+
+    bool isSleeping() const;
+
+Q_SIGNALS:
+    void aboutToSleep();
+    void resumed();
+
+private Q_SLOTS:
+    void OnPrepareForSleep(bool sleep);
+
+private:
+    QDBusServiceWatcher *m_logindWatcher;
+    QTimer *m_watchdogTimer;
+    bool m_sleeping = false;
+};
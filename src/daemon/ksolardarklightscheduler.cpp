@@ -5,9 +5,13 @@
 */
 
 #include "ksolardarklightscheduler.h"
+#include "kdarklightschedulecache.h"
 
-KSolarDarkLightScheduler::KSolarDarkLightScheduler(const QGeoCoordinate &coordinate)
+#include <cmath>
+
+KSolarDarkLightScheduler::KSolarDarkLightScheduler(const QGeoCoordinate &coordinate, KDarkLightScheduleCache *cache)
     : m_coordinate(coordinate)
+    , m_cache(cache)
 {
 }
 
@@ -16,9 +20,75 @@ QGeoCoordinate KSolarDarkLightScheduler::coordinate() const
     return m_coordinate;
 }
 
+static qreal degreesToRadians(qreal degrees)
+{
+    return degrees * M_PI / 180;
+}
+
+static qreal cosHourAngle(qreal latitude, qreal declination, qreal altitude)
+{
+    return (std::sin(altitude) - std::sin(latitude) * std::sin(declination)) / (std::cos(latitude) * std::cos(declination));
+}
+
+std::optional<std::chrono::seconds> KSolarDarkLightScheduler::estimateTransitionShift(const QGeoCoordinate &coordinate, const QDateTime &referenceDateTime) const
+{
+    return estimateTransitionShift(m_coordinate, coordinate, referenceDateTime);
+}
+
+std::optional<std::chrono::seconds> KSolarDarkLightScheduler::estimateTransitionShift(const QGeoCoordinate &from, const QGeoCoordinate &to, const QDateTime &referenceDateTime)
+{
+    // The sun moves 15 degrees per hour, so every degree of longitude shifts the transitions by 4 minutes.
+    const qreal secondsPerLongitude = 240;
+    const qreal secondsPerRadian = 86400 / (2 * M_PI);
+
+    const qreal latitude = degreesToRadians(from.latitude());
+    const qreal otherLatitude = degreesToRadians(to.latitude());
+    const qreal declination = degreesToRadians(-23.44 * std::cos(2 * M_PI * (referenceDateTime.date().dayOfYear() + 10) / 365));
+
+    // The hour angle of a transition H satisfies cos(H) = (sin(h) - sin(φ) sin(δ)) / (cos(φ) cos(δ)), where h is the
+    // altitude of the sun at sunrise/sunset and at the start/end of the civil twilight, so dH/dφ can be computed cheaply.
+    qreal secondsPerLatitude = 0;
+    for (const qreal altitude : {degreesToRadians(-0.833), degreesToRadians(-6)}) {
+        const qreal cosH = cosHourAngle(latitude, declination, altitude);
+        const qreal otherCosH = cosHourAngle(otherLatitude, declination, altitude);
+        const bool polar = std::abs(cosH) >= 1;
+        const bool otherPolar = std::abs(otherCosH) >= 1;
+
+        // The sun does not cross this altitude at either location, so moving between them changes nothing.
+        if (polar && otherPolar) {
+            continue;
+        }
+        // The transition appears or disappears, the derivative says nothing about that.
+        if (polar || otherPolar) {
+            return std::nullopt;
+        }
+
+        // The derivative grows quickly towards the polar days and nights, so it is averaged between both
+        // locations, which errs on the larger side.
+        const auto derivative = [&](qreal phi, qreal cosPhiH) {
+            const qreal sinH = std::sqrt(1 - cosPhiH * cosPhiH);
+            return std::abs((std::sin(phi) * std::sin(altitude) - std::sin(declination)) / (std::pow(std::cos(phi), 2) * std::cos(declination) * sinH));
+        };
+        const qreal averageDerivative = (derivative(latitude, cosH) + derivative(otherLatitude, otherCosH)) / 2;
+        secondsPerLatitude = std::max(secondsPerLatitude, averageDerivative * secondsPerRadian);
+    }
+
+    const qreal latitudeDelta = otherLatitude - latitude;
+    const qreal longitudeDelta = std::remainder(to.longitude() - from.longitude(), 360);
+
+    return std::chrono::seconds(std::llround(std::abs(latitudeDelta) * secondsPerLatitude + std::abs(longitudeDelta) * secondsPerLongitude));
+}
+
 KDarkLightSchedule KSolarDarkLightScheduler::schedule(const QDateTime &referenceDateTime)
 {
-    if (auto schedule = KDarkLightSchedule::forecast(referenceDateTime, m_coordinate.latitude(), m_coordinate.longitude())) {
+    std::optional<KDarkLightSchedule> schedule;
+    if (m_cache) {
+        schedule = m_cache->forecast(referenceDateTime, m_coordinate);
+    } else {
+        schedule = KDarkLightSchedule::forecast(referenceDateTime, m_coordinate.latitude(), m_coordinate.longitude());
+    }
+
+    if (schedule) {
         return *schedule;
     }
     return KDarkLightSchedule::forecast(referenceDateTime);
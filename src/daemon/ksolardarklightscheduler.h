@@ -10,15 +10,30 @@
 
 #include <QGeoCoordinate>
 
+#include <chrono>
+#include <optional>
+
+class KDarkLightScheduleCache;
+
 class KSolarDarkLightScheduler : public KDarkLightScheduler
 {
 public:
-    explicit KSolarDarkLightScheduler(const QGeoCoordinate &coordinate);
+    explicit KSolarDarkLightScheduler(const QGeoCoordinate &coordinate, KDarkLightScheduleCache *cache = nullptr);
 
     QGeoCoordinate coordinate() const;
 
+    /*
+     * Estimates how far the transitions around the given date would move if the location changed
+     * to the specified \a coordinate. Transitions that happen at neither location, e.g. during polar
+     * days and nights, do not move. Returns std::nullopt if a transition happens at only one of the
+     * locations, the estimate cannot be made then.
+     */
+    std::optional<std::chrono::seconds> estimateTransitionShift(const QGeoCoordinate &coordinate, const QDateTime &referenceDateTime) const;
+    static std::optional<std::chrono::seconds> estimateTransitionShift(const QGeoCoordinate &from, const QGeoCoordinate &to, const QDateTime &referenceDateTime);
+
     KDarkLightSchedule schedule(const QDateTime &referenceDateTime) override;
 
 private:
     QGeoCoordinate m_coordinate;
+    KDarkLightScheduleCache *m_cache;
 };
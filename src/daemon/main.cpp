@@ -4,21 +4,76 @@
     SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
+#include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusError>
 
 #include <KDBusService>
+#include <KSignalHandler>
+
+#include <signal.h>
 
 #include "kdarklightmanager.h"
+#include "kdarklightsharedinterface.h"
+#include "knighttimetrace_p.h"
+
+static int runSystemInstance()
+{
+    QDBusConnection bus = QDBusConnection::systemBus();
+    KDarkLightSharedInterface sharedInterface(bus);
+    if (!bus.registerService(QStringLiteral("org.kde.NightTime"))) {
+        qWarning("Failed to register org.kde.NightTime on the system bus: %s", qPrintable(bus.lastError().message()));
+        return 1;
+    }
+
+    return QCoreApplication::exec();
+}
 
 int main(int argc, char **argv)
 {
+    const qint64 startTimestamp = KNightTimeTracer::timestamp();
+
     QCoreApplication app(argc, argv);
     app.setApplicationName(QStringLiteral("NightTime"));
     app.setOrganizationDomain(QStringLiteral("kde.org"));
 
+    // The tracer is started only now, so the process name in the trace is correct.
+    KNightTimeTracer::self()->complete("startup", "initialize", startTimestamp);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption systemOption(QStringLiteral("system"), QStringLiteral("Serve schedules to all sessions on the system bus"));
+    parser.addOption(systemOption);
+    parser.process(app);
+
+    // Exit normally when stopped, so the buffered trace events are written out.
+    KSignalHandler::self()->watchSignal(SIGTERM);
+    QObject::connect(KSignalHandler::self(), &KSignalHandler::signalReceived, &app, [](int signal) {
+        if (signal == SIGTERM) {
+            QCoreApplication::quit();
+        }
+    });
+
+    // The system instance only computes schedules for the per-session daemons, see the SharedInstance setting.
+    if (parser.isSet(systemOption)) {
+        return runSystemInstance();
+    }
+
     KDarkLightManager daemon;
     daemon.reconfigure();
 
+    const qint64 registerTimestamp = KNightTimeTracer::timestamp();
     KDBusService dbusService(KDBusService::Unique);
+    KNightTimeTracer::self()->complete("startup", "registerService", registerTimestamp);
+
+    // Release the service name before exiting so the next call starts a new instance via D-Bus activation.
+    // The calls that have been routed to this instance before that are still queued, so the daemon
+    // quits only after they have been dispatched and rejected.
+    QObject::connect(&daemon, &KDarkLightManager::idle, &app, [&dbusService]() {
+        dbusService.unregister();
+        QMetaObject::invokeMethod(qApp, &QCoreApplication::quit, Qt::QueuedConnection);
+    });
+
     return app.exec();
 }
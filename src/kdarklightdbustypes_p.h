@@ -21,6 +21,19 @@ struct KNightTimeDbusCycle
 
     KDarkLightCycle into() const;
     static KNightTimeDbusCycle from(const KDarkLightCycle &cycle);
+
+    static KDarkLightSchedule intoSchedule(const QList<KNightTimeDbusCycle> &cycles);
+    static QList<KNightTimeDbusCycle> fromSchedule(const KDarkLightSchedule &schedule);
+};
+
+struct KNightTimeDbusTransition
+{
+    uint type;
+    qint64 startTimestamp;
+    qint64 endTimestamp;
+
+    KDarkLightTransition into() const;
+    static KNightTimeDbusTransition from(const KDarkLightTransition &transition);
 };
 
 struct KNightTimeDbusSchedule
@@ -56,6 +69,26 @@ inline const QDBusArgument &operator>>(const QDBusArgument &argument, KNightTime
     return argument;
 }
 
+inline const QDBusArgument &operator<<(QDBusArgument &argument, const KNightTimeDbusTransition &transition)
+{
+    argument.beginStructure();
+    argument << transition.type;
+    argument << transition.startTimestamp;
+    argument << transition.endTimestamp;
+    argument.endStructure();
+    return argument;
+}
+
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, KNightTimeDbusTransition &transition)
+{
+    argument.beginStructure();
+    argument >> transition.type;
+    argument >> transition.startTimestamp;
+    argument >> transition.endTimestamp;
+    argument.endStructure();
+    return argument;
+}
+
 inline const QDBusArgument &operator<<(QDBusArgument &argument, const KNightTimeDbusSchedule &schedule)
 {
     argument.beginStructure();
@@ -92,13 +125,8 @@ inline KNightTimeDbusCycle KNightTimeDbusCycle::from(const KDarkLightCycle &cycl
     };
 }
 
-inline KDarkLightSchedule KNightTimeDbusSchedule::into() const
+inline KDarkLightSchedule KNightTimeDbusCycle::intoSchedule(const QList<KNightTimeDbusCycle> &dbusCycles)
 {
-    if (name != QLatin1String("dynamic")) {
-        return KDarkLightSchedule();
-    }
-
-    const QList<KNightTimeDbusCycle> dbusCycles = qdbus_cast<QList<KNightTimeDbusCycle>>(data.variant().value<QDBusArgument>());
     QList<KDarkLightCycle> cycles;
     cycles.reserve(dbusCycles.size());
     for (const auto &dbusCycle : dbusCycles) {
@@ -108,7 +136,7 @@ inline KDarkLightSchedule KNightTimeDbusSchedule::into() const
     return KDarkLightSchedule(cycles);
 }
 
-inline KNightTimeDbusSchedule KNightTimeDbusSchedule::from(const KDarkLightSchedule &schedule)
+inline QList<KNightTimeDbusCycle> KNightTimeDbusCycle::fromSchedule(const KDarkLightSchedule &schedule)
 {
     const QList<KDarkLightCycle> cycles = schedule.cycles();
     QList<KNightTimeDbusCycle> dbusCycles;
@@ -117,11 +145,42 @@ inline KNightTimeDbusSchedule KNightTimeDbusSchedule::from(const KDarkLightSched
         dbusCycles.append(KNightTimeDbusCycle::from(cycle));
     }
 
+    return dbusCycles;
+}
+
+inline KDarkLightTransition KNightTimeDbusTransition::into() const
+{
+    return KDarkLightTransition(type == KDarkLightTransition::Morning ? KDarkLightTransition::Morning : KDarkLightTransition::Evening,
+                                QDateTime::fromMSecsSinceEpoch(startTimestamp),
+                                QDateTime::fromMSecsSinceEpoch(endTimestamp));
+}
+
+inline KNightTimeDbusTransition KNightTimeDbusTransition::from(const KDarkLightTransition &transition)
+{
+    return KNightTimeDbusTransition{
+        .type = uint(transition.type()),
+        .startTimestamp = transition.startDateTime().toMSecsSinceEpoch(),
+        .endTimestamp = transition.endDateTime().toMSecsSinceEpoch(),
+    };
+}
+
+inline KDarkLightSchedule KNightTimeDbusSchedule::into() const
+{
+    if (name != QLatin1String("dynamic")) {
+        return KDarkLightSchedule();
+    }
+
+    return KNightTimeDbusCycle::intoSchedule(qdbus_cast<QList<KNightTimeDbusCycle>>(data.variant().value<QDBusArgument>()));
+}
+
+inline KNightTimeDbusSchedule KNightTimeDbusSchedule::from(const KDarkLightSchedule &schedule)
+{
     return KNightTimeDbusSchedule{
         .name = QStringLiteral("dynamic"),
-        .data = QDBusVariant(QVariant::fromValue(dbusCycles)),
+        .data = QDBusVariant(QVariant::fromValue(KNightTimeDbusCycle::fromSchedule(schedule))),
     };
 }
 
 Q_DECLARE_METATYPE(KNightTimeDbusCycle)
+Q_DECLARE_METATYPE(KNightTimeDbusTransition)
 Q_DECLARE_METATYPE(KNightTimeDbusSchedule)
@@ -0,0 +1,162 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "kdarklightphasetracker.h"
+#include "kdarklightphasetracker_p.h"
+#include "kdarklightscheduleprovider.h"
+
+static KDarkLightPhaseTracker::Phase phaseBefore(const KDarkLightTransition &transition)
+{
+    switch (transition.type()) {
+    case KDarkLightTransition::Morning:
+        return KDarkLightPhaseTracker::Night;
+    case KDarkLightTransition::Evening:
+        return KDarkLightPhaseTracker::Day;
+    }
+    Q_UNREACHABLE();
+}
+
+static KDarkLightPhaseTracker::Phase phaseDuring(const KDarkLightTransition &transition)
+{
+    switch (transition.type()) {
+    case KDarkLightTransition::Morning:
+        return KDarkLightPhaseTracker::Morning;
+    case KDarkLightTransition::Evening:
+        return KDarkLightPhaseTracker::Evening;
+    }
+    Q_UNREACHABLE();
+}
+
+static KDarkLightPhaseTracker::Phase phaseAfter(const KDarkLightTransition &transition)
+{
+    switch (transition.type()) {
+    case KDarkLightTransition::Morning:
+        return KDarkLightPhaseTracker::Day;
+    case KDarkLightTransition::Evening:
+        return KDarkLightPhaseTracker::Night;
+    }
+    Q_UNREACHABLE();
+}
+
+KDarkLightPhaseTrackerPrivate *KDarkLightPhaseTrackerPrivate::get(KDarkLightPhaseTracker *tracker)
+{
+    return tracker->d.get();
+}
+
+void KDarkLightPhaseTrackerPrivate::setClock(KNightTimeClock *newClock)
+{
+    if (clock == newClock) {
+        return;
+    }
+
+    QObject::disconnect(skewConnection);
+
+    clock = newClock;
+    timer = clock->createTimer();
+    QObject::connect(timer.get(), &KNightTimeTimer::timeout, q, [this]() {
+        ++wakeups;
+        update();
+    });
+    skewConnection = QObject::connect(clock, &KNightTimeClock::skewed, q, [this]() {
+        update();
+    });
+
+    update();
+}
+
+void KDarkLightPhaseTrackerPrivate::update()
+{
+    const QDateTime now = clock->currentDateTime();
+    const KDarkLightSchedule schedule = provider->schedule();
+
+    KDarkLightPhaseTracker::Phase newPhase = KDarkLightPhaseTracker::Day;
+    qreal newProgress = 0.0;
+    QDateTime wakeupDateTime;
+
+    // KDarkLightTransition::test() has some tolerance, so the previous transition may actually start
+    // a bit later. The boundaries are compared exactly here.
+    if (const auto previousTransition = schedule.previousTransition(now)) {
+        if (now < previousTransition->startDateTime()) {
+            newPhase = phaseBefore(*previousTransition);
+            wakeupDateTime = previousTransition->startDateTime();
+        } else if (now < previousTransition->endDateTime()) {
+            newPhase = phaseDuring(*previousTransition);
+            newProgress = previousTransition->progress(now);
+            wakeupDateTime = previousTransition->endDateTime();
+            if (progressInterval > std::chrono::milliseconds::zero()) {
+                wakeupDateTime = std::min(wakeupDateTime, now.addDuration(progressInterval));
+            }
+        } else {
+            newPhase = phaseAfter(*previousTransition);
+            if (const auto nextTransition = schedule.nextTransition(now)) {
+                wakeupDateTime = nextTransition->startDateTime();
+            }
+        }
+    } else if (const auto nextTransition = schedule.nextTransition(now)) {
+        newPhase = phaseBefore(*nextTransition);
+        wakeupDateTime = nextTransition->startDateTime();
+    }
+
+    if (wakeupDateTime.isValid()) {
+        timer->start(std::chrono::milliseconds(std::max<qint64>(1, now.msecsTo(wakeupDateTime))));
+    } else {
+        timer->stop();
+    }
+
+    const bool phaseChanged = phase != newPhase;
+    const bool progressChanged = progress != newProgress;
+    phase = newPhase;
+    progress = newProgress;
+
+    if (phaseChanged) {
+        Q_EMIT q->phaseChanged();
+    }
+    if (progressChanged) {
+        Q_EMIT q->progressChanged();
+    }
+}
+
+KDarkLightPhaseTracker::KDarkLightPhaseTracker(KDarkLightScheduleProvider *provider, QObject *parent)
+    : QObject(parent)
+    , d(new KDarkLightPhaseTrackerPrivate)
+{
+    d->q = this;
+    d->provider = provider;
+    connect(provider, &KDarkLightScheduleProvider::scheduleChanged, this, [this]() {
+        d->update();
+    });
+
+    d->setClock(KNightTimeClock::system());
+}
+
+KDarkLightPhaseTracker::~KDarkLightPhaseTracker()
+{
+}
+
+KDarkLightPhaseTracker::Phase KDarkLightPhaseTracker::phase() const
+{
+    return d->phase;
+}
+
+qreal KDarkLightPhaseTracker::progress() const
+{
+    return d->progress;
+}
+
+std::chrono::milliseconds KDarkLightPhaseTracker::progressInterval() const
+{
+    return d->progressInterval;
+}
+
+void KDarkLightPhaseTracker::setProgressInterval(std::chrono::milliseconds interval)
+{
+    if (d->progressInterval != interval) {
+        d->progressInterval = interval;
+        d->update();
+    }
+}
+
+#include "moc_kdarklightphasetracker.cpp"
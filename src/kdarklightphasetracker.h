@@ -0,0 +1,109 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "knighttime_export.h"
+
+#include <QObject>
+
+#include <chrono>
+#include <memory>
+
+class KDarkLightScheduleProvider;
+class KDarkLightPhaseTrackerPrivate;
+
+/*!
+ * \class KDarkLightPhaseTracker
+ * \inmodule KNightTime
+ * \brief The KDarkLightPhaseTracker tracks the current phase of the dark-light cycle.
+ *
+ * The tracker follows the schedule of the specified KDarkLightScheduleProvider and notifies when
+ * the phase changes or a transition makes progress. Between transitions, the tracker only wakes
+ * up at the start of the next transition.
+ *
+ * Example usage:
+ *
+ * \code
+ * auto provider = new KDarkLightScheduleProvider(state);
+ * auto tracker = new KDarkLightPhaseTracker(provider);
+ * tracker->setProgressInterval(std::chrono::seconds(10));
+ * connect(tracker, &KDarkLightPhaseTracker::phaseChanged, [tracker]() {
+ *     qDebug() << "phase:" << tracker->phase();
+ * });
+ * connect(tracker, &KDarkLightPhaseTracker::progressChanged, [tracker]() {
+ *     qDebug() << "progress:" << tracker->progress();
+ * });
+ * \endcode
+ */
+class KNIGHTTIME_EXPORT KDarkLightPhaseTracker : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Phase phase READ phase NOTIFY phaseChanged)
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+
+public:
+    /*!
+     * The Phase enum specifies the phase of the dark-light cycle.
+     *
+     * \value Night It is night time
+     * \value Morning Transitioning from night time to daylight
+     * \value Day It is daylight
+     * \value Evening Transitioning from daylight to night time
+     */
+    enum Phase {
+        Night,
+        Morning,
+        Day,
+        Evening,
+    };
+    Q_ENUM(Phase)
+
+    /*!
+     * Constructs the phase tracker for the schedule provided by the specified \a provider. The
+     * provider must outlive the tracker.
+     */
+    explicit KDarkLightPhaseTracker(KDarkLightScheduleProvider *provider, QObject *parent = nullptr);
+    ~KDarkLightPhaseTracker() override;
+
+    /*!
+     * Returns the current phase.
+     */
+    Phase phase() const;
+
+    /*!
+     * Returns the progress of the current transition. The progress value is in [0.0, 1.0] range.
+     * If no transition is in progress, i.e. the phase is either Day or Night, 0.0 is returned.
+     */
+    qreal progress() const;
+
+    /*!
+     * Returns how often the progressChanged() signal is emitted while a transition is in progress.
+     * The default interval is one minute.
+     */
+    std::chrono::milliseconds progressInterval() const;
+
+    /*!
+     * Sets the progress update interval to \a interval. If the interval is zero, the progress will
+     * be updated only when the phase changes.
+     */
+    void setProgressInterval(std::chrono::milliseconds interval);
+
+Q_SIGNALS:
+    /*!
+     * This signal is emitted when the phase changes.
+     */
+    void phaseChanged();
+
+    /*!
+     * This signal is emitted when the progress of the current transition changes.
+     */
+    void progressChanged();
+
+private:
+    friend class KDarkLightPhaseTrackerPrivate;
+    std::unique_ptr<KDarkLightPhaseTrackerPrivate> d;
+};
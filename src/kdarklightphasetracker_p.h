@@ -0,0 +1,37 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "kdarklightphasetracker.h"
+#include "knighttimeclock_p.h"
+
+/*
+ * This is private API, it is exported only for tests.
+ */
+class KNIGHTTIME_EXPORT KDarkLightPhaseTrackerPrivate
+{
+public:
+    static KDarkLightPhaseTrackerPrivate *get(KDarkLightPhaseTracker *tracker);
+
+    /*
+     * Makes the tracker use the specified \a clock instead of the system clock. The clock must
+     * outlive the tracker.
+     */
+    void setClock(KNightTimeClock *clock);
+
+    void update();
+
+    KDarkLightPhaseTracker *q;
+    KDarkLightScheduleProvider *provider;
+    KNightTimeClock *clock = nullptr;
+    std::unique_ptr<KNightTimeTimer> timer;
+    QMetaObject::Connection skewConnection;
+    std::chrono::milliseconds progressInterval = std::chrono::minutes(1);
+    KDarkLightPhaseTracker::Phase phase = KDarkLightPhaseTracker::Day;
+    qreal progress = 0.0;
+    quint64 wakeups = 0;
+};
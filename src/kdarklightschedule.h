@@ -10,6 +10,13 @@
 
 #include <QDateTime>
 
+#include <memory>
+
+namespace KNightTimeCore
+{
+struct Schedule;
+}
+
 /*!
  * \class KDarkLightTransition
  * \inmodule KNightTime
@@ -174,7 +181,7 @@ public:
      */
     KDarkLightSchedule(const QList<KDarkLightCycle> &cycles);
 
-    auto operator<=>(const KDarkLightSchedule &other) const = default;
+    bool operator==(const KDarkLightSchedule &other) const;
 
     /*!
      * Retruns dark-light cycles stored in this schedule. A null schedule has no cycles in it.
@@ -222,6 +229,8 @@ public:
 
 private:
     QList<KDarkLightCycle> m_cycles;
+    // The cycles converted once for the maths in KNightTimeCore, it is shared between the copies.
+    std::shared_ptr<const KNightTimeCore::Schedule> m_coreSchedule;
 };
 
 KNIGHTTIME_EXPORT QDebug operator<<(QDebug debug, const KDarkLightTransition &transition);
@@ -0,0 +1,253 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "kdarklightschedulefile_p.h"
+#include "knighttimelogging.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+
+const quint32 s_magic = 0x53544e4b; // "KNTS"
+const quint32 s_version = 1;
+const quint32 s_maxCycleCount = 32;
+
+struct FileCycle
+{
+    qint64 noonTimestamp;
+    qint64 morningStartTimestamp;
+    qint64 morningEndTimestamp;
+    qint64 eveningStartTimestamp;
+    qint64 eveningEndTimestamp;
+};
+
+struct FileContents
+{
+    quint32 magic;
+    quint32 version;
+    std::atomic<quint64> sequence; // odd while the schedule is being written
+    quint64 generation;
+    quint32 cycleCount;
+    quint32 padding;
+    FileCycle cycles[s_maxCycleCount];
+};
+
+// The sequence counter is shared between processes, so it must not be implemented with a lock.
+static_assert(std::atomic<quint64>::is_always_lock_free);
+
+}
+
+static void writeCycles(FileContents *contents, const KDarkLightSchedule &schedule)
+{
+    const QList<KDarkLightCycle> cycles = schedule.cycles();
+    const quint32 cycleCount = std::min<quint32>(cycles.size(), s_maxCycleCount);
+
+    contents->cycleCount = cycleCount;
+    for (quint32 i = 0; i < cycleCount; ++i) {
+        const KDarkLightCycle &cycle = cycles[i];
+        contents->cycles[i] = FileCycle{
+            .noonTimestamp = cycle.noonDateTime().toMSecsSinceEpoch(),
+            .morningStartTimestamp = cycle.morning().startDateTime().toMSecsSinceEpoch(),
+            .morningEndTimestamp = cycle.morning().endDateTime().toMSecsSinceEpoch(),
+            .eveningStartTimestamp = cycle.evening().startDateTime().toMSecsSinceEpoch(),
+            .eveningEndTimestamp = cycle.evening().endDateTime().toMSecsSinceEpoch(),
+        };
+    }
+}
+
+KDarkLightScheduleFile::KDarkLightScheduleFile(std::unique_ptr<QFile> file, uchar *data)
+    : m_file(std::move(file))
+    , m_data(data)
+{
+}
+
+KDarkLightScheduleFile::~KDarkLightScheduleFile()
+{
+    m_file->unmap(m_data);
+}
+
+QString KDarkLightScheduleFile::defaultFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + QLatin1String("/knighttime/schedule");
+}
+
+QString KDarkLightScheduleFile::cacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QLatin1String("/knighttime/schedule");
+}
+
+bool KDarkLightScheduleFile::save(const QString &fileName, const KDarkLightSchedule &schedule)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    auto contents = std::make_unique<FileContents>();
+    contents->magic = s_magic;
+    contents->version = s_version;
+    contents->generation = 1;
+    writeCycles(contents.get(), schedule);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KNIGHTTIME) << "Failed to open" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(contents.get()), sizeof(FileContents));
+    if (!file.commit()) {
+        qCWarning(KNIGHTTIME) << "Failed to save" << fileName << ":" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+std::unique_ptr<KDarkLightScheduleFile> KDarkLightScheduleFile::create(const QString &fileName)
+{
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::ReadWrite)) {
+        qCWarning(KNIGHTTIME) << "Failed to open" << fileName << ":" << file->errorString();
+        return nullptr;
+    }
+
+    const bool valid = file->size() == sizeof(FileContents);
+    if (!valid && !file->resize(sizeof(FileContents))) {
+        qCWarning(KNIGHTTIME) << "Failed to resize" << fileName << ":" << file->errorString();
+        return nullptr;
+    }
+
+    uchar *data = file->map(0, sizeof(FileContents));
+    if (!data) {
+        qCWarning(KNIGHTTIME) << "Failed to map" << fileName << ":" << file->errorString();
+        return nullptr;
+    }
+
+    // Keep the generation counter of the previous daemon instance so clients that still have
+    // the file mapped notice the new schedule.
+    auto contents = reinterpret_cast<FileContents *>(data);
+    if (!valid || contents->magic != s_magic || contents->version != s_version) {
+        std::memset(data, 0, sizeof(FileContents));
+        contents->magic = s_magic;
+        contents->version = s_version;
+    } else if (contents->sequence.load(std::memory_order_relaxed) & 1) {
+        contents->sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    return std::unique_ptr<KDarkLightScheduleFile>(new KDarkLightScheduleFile(std::move(file), data));
+}
+
+std::unique_ptr<KDarkLightScheduleFile> KDarkLightScheduleFile::open(const QString &fileName)
+{
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    if (file->size() != sizeof(FileContents)) {
+        return nullptr;
+    }
+
+    uchar *data = file->map(0, sizeof(FileContents));
+    if (!data) {
+        return nullptr;
+    }
+
+    const auto contents = reinterpret_cast<const FileContents *>(data);
+    if (contents->magic != s_magic || contents->version != s_version) {
+        file->unmap(data);
+        return nullptr;
+    }
+
+    return std::unique_ptr<KDarkLightScheduleFile>(new KDarkLightScheduleFile(std::move(file), data));
+}
+
+QString KDarkLightScheduleFile::fileName() const
+{
+    return m_file->fileName();
+}
+
+quint64 KDarkLightScheduleFile::generation() const
+{
+    const auto contents = reinterpret_cast<const FileContents *>(m_data);
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        const quint64 sequence = contents->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+
+        const quint64 generation = contents->generation;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (contents->sequence.load(std::memory_order_relaxed) == sequence) {
+            return generation;
+        }
+    }
+    return 0;
+}
+
+quint64 KDarkLightScheduleFile::publish(const KDarkLightSchedule &schedule)
+{
+    auto contents = reinterpret_cast<FileContents *>(m_data);
+
+    const quint64 sequence = contents->sequence.load(std::memory_order_relaxed);
+    contents->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    contents->generation++;
+    writeCycles(contents, schedule);
+
+    contents->sequence.store(sequence + 2, std::memory_order_release);
+    return contents->generation;
+}
+
+std::optional<std::pair<quint64, KDarkLightSchedule>> KDarkLightScheduleFile::read() const
+{
+    const auto contents = reinterpret_cast<const FileContents *>(m_data);
+
+    quint64 generation;
+    quint32 cycleCount;
+    FileCycle fileCycles[s_maxCycleCount];
+
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        const quint64 sequence = contents->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+
+        generation = contents->generation;
+        cycleCount = std::min(contents->cycleCount, s_maxCycleCount);
+        std::memcpy(fileCycles, contents->cycles, sizeof(FileCycle) * cycleCount);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (contents->sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        if (!generation) {
+            return std::nullopt;
+        }
+
+        QList<KDarkLightCycle> cycles;
+        cycles.reserve(cycleCount);
+        for (quint32 i = 0; i < cycleCount; ++i) {
+            const FileCycle &cycle = fileCycles[i];
+            cycles.append(KDarkLightCycle(QDateTime::fromMSecsSinceEpoch(cycle.noonTimestamp),
+                                          KDarkLightTransition(KDarkLightTransition::Morning, QDateTime::fromMSecsSinceEpoch(cycle.morningStartTimestamp), QDateTime::fromMSecsSinceEpoch(cycle.morningEndTimestamp)),
+                                          KDarkLightTransition(KDarkLightTransition::Evening, QDateTime::fromMSecsSinceEpoch(cycle.eveningStartTimestamp), QDateTime::fromMSecsSinceEpoch(cycle.eveningEndTimestamp))));
+        }
+
+        return std::make_pair(generation, KDarkLightSchedule(cycles));
+    }
+
+    return std::nullopt;
+}
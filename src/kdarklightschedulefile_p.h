@@ -0,0 +1,78 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "kdarklightschedule.h"
+#include "knighttime_export.h"
+
+#include <QFile>
+
+/*
+ * The KDarkLightScheduleFile provides access to the schedule published by knighttimed in a memory
+ * mapped file. The file has a fixed size, the schedule is updated in place and it is protected by
+ * a sequence lock, so readers never observe a partially written schedule and never block the writer.
+ *
+ * knighttimed also saves a copy of the schedule in the cache directory, which outlives the session.
+ * That file is replaced atomically, so it can be mapped and read the same way.
+ *
+ * This is private API, it is exported only for knighttimed.
+ */
+class KNIGHTTIME_EXPORT KDarkLightScheduleFile
+{
+public:
+    ~KDarkLightScheduleFile();
+
+    /*
+     * Returns the path of the file where knighttimed publishes the schedule.
+     */
+    static QString defaultFileName();
+
+    /*
+     * Returns the path of the file where knighttimed saves the last known schedule.
+     */
+    static QString cacheFileName();
+
+    /*
+     * Atomically replaces the file with the specified \a fileName with a file that contains the
+     * given \a schedule. The generation of the saved schedule is always 1.
+     */
+    static bool save(const QString &fileName, const KDarkLightSchedule &schedule);
+
+    /*
+     * Opens the schedule file for writing, the file is created if it does not exist.
+     */
+    static std::unique_ptr<KDarkLightScheduleFile> create(const QString &fileName);
+
+    /*
+     * Opens an existing schedule file for reading.
+     */
+    static std::unique_ptr<KDarkLightScheduleFile> open(const QString &fileName);
+
+    QString fileName() const;
+
+    /*
+     * Returns the generation of the currently published schedule.
+     */
+    quint64 generation() const;
+
+    /*
+     * Publishes the specified \a schedule and returns its generation.
+     */
+    quint64 publish(const KDarkLightSchedule &schedule);
+
+    /*
+     * Reads the published schedule. If the schedule is being written at the same time and a consistent
+     * snapshot cannot be taken, a std::nullopt value will be returned.
+     */
+    std::optional<std::pair<quint64, KDarkLightSchedule>> read() const;
+
+private:
+    explicit KDarkLightScheduleFile(std::unique_ptr<QFile> file, uchar *data);
+
+    std::unique_ptr<QFile> m_file;
+    uchar *m_data;
+};
@@ -6,6 +6,34 @@
 
 #include "kdarklightscheduleprovider.h"
 #include "kdarklightscheduleprovider_p.h"
+#include "knighttimeclock_p.h"
+
+// A schedule restored from a file is only used if it covers the current time and is not older than
+// the state that the application has saved, the cycles start with the day before the forecast.
+static bool isRestoredScheduleUsable(const KDarkLightSchedule &restored, const std::optional<KDarkLightSchedule> &fallback, const QDateTime &now)
+{
+    const QList<KDarkLightCycle> cycles = restored.cycles();
+    if (cycles.isEmpty() || now < cycles.first().morning().startDateTime() || cycles.last().evening().endDateTime() <= now) {
+        return false;
+    }
+
+    if (fallback && !fallback->cycles().isEmpty()) {
+        return fallback->cycles().first().noonDateTime() <= cycles.first().noonDateTime();
+    }
+
+    return true;
+}
+
+void KDarkLightScheduleProviderPrivate::publish()
+{
+    // The snapshot is immutable, readers keep the old one alive for as long as they need it.
+    auto newSnapshot = std::make_shared<const KDarkLightSchedule>(schedule);
+#if defined(__cpp_lib_atomic_shared_ptr)
+    snapshot.store(std::move(newSnapshot), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&snapshot, std::move(newSnapshot), std::memory_order_release);
+#endif
+}
 
 KDarkLightScheduleProvider::KDarkLightScheduleProvider(const QString &state, QObject *parent)
     : QObject(parent)
@@ -16,21 +44,31 @@ KDarkLightScheduleProvider::KDarkLightScheduleProvider(const QString &state, QOb
         const auto schedule = d->subscription->schedule().value_or(KDarkLightSchedule());
         if (d->schedule != schedule) {
             d->schedule = schedule;
-            d->state = d->subscription->state();
+            d->subscribed = true;
+            d->fallbackState.clear();
+            d->publish();
             Q_EMIT scheduleChanged();
         }
     });
 
-    if (auto schedule = d->subscription->schedule()) {
-        d->schedule = std::move(*schedule);
-        d->state = d->subscription->state();
-    } else if (auto schedule = KDarkLightSchedule::fromState(state)) {
+    const auto fallback = KDarkLightSchedule::fromState(state);
+
+    auto schedule = d->subscription->schedule();
+    if (schedule && d->subscription->isRestored() && !isRestoredScheduleUsable(*schedule, fallback, KNightTimeClock::system()->currentDateTime())) {
+        schedule.reset();
+    }
+
+    if (schedule) {
         d->schedule = std::move(*schedule);
-        d->state = state;
+        d->subscribed = true;
+    } else if (fallback) {
+        d->schedule = *fallback;
+        d->fallbackState = state;
     } else {
-        d->schedule = KDarkLightSchedule::forecast(QDateTime::currentDateTime());
-        d->state = d->schedule.toState();
+        d->schedule = KDarkLightSchedule::forecast(KNightTimeClock::system()->currentDateTime());
     }
+
+    d->publish();
 }
 
 KDarkLightScheduleProvider::~KDarkLightScheduleProvider()
@@ -42,9 +80,25 @@ KDarkLightSchedule KDarkLightScheduleProvider::schedule() const
     return d->schedule;
 }
 
+std::shared_ptr<const KDarkLightSchedule> KDarkLightScheduleProvider::snapshot() const
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return d->snapshot.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&d->snapshot, std::memory_order_acquire);
+#endif
+}
+
 QString KDarkLightScheduleProvider::state() const
 {
-    return d->state;
+    // The subscription caches the state of its schedule, so there is no need to keep another copy.
+    if (d->subscribed) {
+        return d->subscription->state();
+    }
+    if (d->fallbackState.isEmpty()) {
+        d->fallbackState = d->schedule.toState();
+    }
+    return d->fallbackState;
 }
 
 #include "moc_kdarklightscheduleprovider.cpp"
@@ -8,6 +8,8 @@
 
 #include "kdarklightschedule.h"
 
+#include <memory>
+
 class KDarkLightScheduleProviderPrivate;
 
 /*!
@@ -37,10 +39,11 @@ class KNIGHTTIME_EXPORT KDarkLightScheduleProvider : public QObject
 
 public:
     /*!
-     * Constructs the schedule provider. If a \a state string is specified, the previous schedule
+     * Constructs the schedule provider. The provider starts with the last schedule saved by the
+     * daemon, if there is one. Otherwise, if a \a state string is specified, the previous schedule
      * will be restored.
      *
-     * If no state string is given, the provider will use the default schedule until the current one
+     * If neither is available, the provider will use the default schedule until the current one
      * is retrieved asynchronously. With the default schedule, morning lasts from 6:00AM to 6:30AM,
      * and evening lasts from 6:00PM to 6:30PM.
      */
@@ -52,6 +55,15 @@ public:
      */
     KDarkLightSchedule schedule() const;
 
+    /*!
+     * Returns the current schedule. Unlike schedule(), this function can be called from any thread
+     * without locking, e.g. from a render thread. The returned schedule is never modified; when the
+     * schedule changes, a new snapshot is published in the thread that the provider lives in.
+     *
+     * The provider must outlive the threads that call this function.
+     */
+    std::shared_ptr<const KDarkLightSchedule> snapshot() const;
+
     /*!
      * Returns the corresponding state string. The state string can be stored in a state config
      * to restore the schedule after a reboot. It can be used to reduce the number of unnecessary animations
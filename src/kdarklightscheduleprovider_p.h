@@ -9,10 +9,23 @@
 #include "kdarklightschedule.h"
 #include "kdarklightschedulesubscription_p.h"
 
+#include <atomic>
+#include <memory>
+#include <version>
+
 class KDarkLightScheduleProviderPrivate
 {
 public:
+    void publish();
+
     KDarkLightSchedule schedule;
-    QString state;
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const KDarkLightSchedule>> snapshot;
+#else
+    // libc++ does not implement std::atomic<std::shared_ptr> yet, use the atomic free functions.
+    std::shared_ptr<const KDarkLightSchedule> snapshot;
+#endif
+    mutable QString fallbackState;
+    bool subscribed = false;
     std::shared_ptr<KDarkLightScheduleSubscription> subscription;
 };
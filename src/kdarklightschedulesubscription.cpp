@@ -6,14 +6,36 @@
 
 #include "kdarklightschedulesubscription_p.h"
 #include "kdarklightdbustypes_p.h"
+#include "kdarklightschedulefile_p.h"
 #include "knighttimelogging.h"
+#include "knighttimetrace_p.h"
 
 #include <QCoreApplication>
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusMetaType>
 #include <QDBusPendingCall>
 #include <QDBusPendingReply>
+#include <QDBusVariant>
 #include <QPointer>
+#include <QRandomGenerator>
+
+using namespace std::chrono_literals;
+
+// When the daemon is restarted, all applications in the session notice it at the same time. The
+// subscriptions are renewed after a random delay, so the new instance is not flooded with calls.
+static constexpr std::chrono::milliseconds s_resubscribeJitter = 500ms;
+
+// The delay before the next attempt grows exponentially if the Subscribe() call keeps failing,
+// e.g. because the daemon cannot be activated.
+static constexpr std::chrono::milliseconds s_retryBaseDelay = 250ms;
+static constexpr std::chrono::milliseconds s_retryMaxDelay = 30s;
+static constexpr int s_maxRetryCount = 8;
+
+// The API versions of the daemon that introduced the Subscribe() options used by the library.
+static constexpr uint s_typedRefreshedVersion = 2;
+static constexpr uint s_waitForAccurateVersion = 2;
+static constexpr uint s_leaseVersion = 3;
 
 std::shared_ptr<KDarkLightScheduleSubscription> KDarkLightScheduleSubscription::globalSubscription()
 {
@@ -30,9 +52,25 @@ std::shared_ptr<KDarkLightScheduleSubscription> KDarkLightScheduleSubscription::
 
 KDarkLightScheduleSubscription::KDarkLightScheduleSubscription(QObject *parent)
     : QObject(parent)
+    , m_resubscribeTimer(std::make_unique<QTimer>())
+    , m_renewTimer(std::make_unique<QTimer>())
+    , m_sharedScheduleFailed(qEnvironmentVariableIntValue("KNIGHTTIME_NO_SHARED_SCHEDULE"))
 {
+    m_resubscribeTimer->setSingleShot(true);
+    connect(m_resubscribeTimer.get(), &QTimer::timeout, this, [this]() {
+        if (!m_cookie && !m_cookieWatcher) {
+            subscribe();
+        }
+    });
+
+    connect(m_renewTimer.get(), &QTimer::timeout, this, &KDarkLightScheduleSubscription::renew);
+
+    qDBusRegisterMetaType<KNightTimeDbusCycle>();
+    qDBusRegisterMetaType<QList<KNightTimeDbusCycle>>();
+
     auto bus = QDBusConnection::sessionBus();
     bus.connect(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Refreshed"), this, SLOT(OnRefreshed(QVariantMap)));
+    bus.connect(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("RefreshedCycles"), this, SLOT(OnRefreshedCycles(QList<KNightTimeDbusCycle>)));
 
     m_daemonWatcher = std::make_unique<QDBusServiceWatcher>(QStringLiteral("org.kde.NightTime"), bus);
     connect(m_daemonWatcher.get(), &QDBusServiceWatcher::serviceRegistered,
@@ -40,6 +78,7 @@ KDarkLightScheduleSubscription::KDarkLightScheduleSubscription(QObject *parent)
     connect(m_daemonWatcher.get(), &QDBusServiceWatcher::serviceUnregistered,
             this, &KDarkLightScheduleSubscription::OnDaemonUnregistered);
 
+    restore();
     subscribe();
 }
 
@@ -48,6 +87,7 @@ KDarkLightScheduleSubscription::~KDarkLightScheduleSubscription()
     if (m_cookie) {
         auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Unsubscribe"));
         message.setArguments({m_cookie.value()});
+        QDBusConnection::sessionBus().asyncCall(message);
     }
 }
 
@@ -56,9 +96,18 @@ std::optional<KDarkLightSchedule> KDarkLightScheduleSubscription::schedule() con
     return m_schedule;
 }
 
+bool KDarkLightScheduleSubscription::isRestored() const
+{
+    return m_restored;
+}
+
 QString KDarkLightScheduleSubscription::state() const
 {
-    return m_state;
+    // Most applications never ask for the state, so it is only serialized when needed.
+    if (!m_state && m_schedule) {
+        m_state = m_schedule->toState();
+    }
+    return m_state.value_or(QString());
 }
 
 void KDarkLightScheduleSubscription::OnSubscribed(const QVariantMap &data)
@@ -70,8 +119,25 @@ void KDarkLightScheduleSubscription::OnSubscribed(const QVariantMap &data)
         return;
     }
 
+    // Renew the lease well before it expires, so a slow reply does not cost the subscription.
+    if (auto it = data.find(QStringLiteral("LeaseDuration")); it != data.end()) {
+        m_renewTimer->start(std::chrono::seconds(it->toUInt()) / 2);
+    } else {
+        m_renewTimer->stop();
+    }
+
     if (auto it = data.find(QStringLiteral("Schedule")); it != data.end()) {
+        m_scheduleFile.reset();
         update(*it);
+    } else if (auto it = data.find(QStringLiteral("ScheduleFile")); it != data.end()) {
+        // The generation of the restored schedule is only meaningful for the same file.
+        if (!m_scheduleFile || m_scheduleFile->fileName() != it->toString()) {
+            m_scheduleFile = KDarkLightScheduleFile::open(it->toString());
+            m_scheduleGeneration = 0;
+        }
+        if (!m_scheduleFile || !updateFromFile()) {
+            fallBackToDBus();
+        }
     } else {
         qCWarning(KNIGHTTIME) << "Subscribe() reply contains no Schedule. Available data:" << data;
     }
@@ -79,11 +145,32 @@ void KDarkLightScheduleSubscription::OnSubscribed(const QVariantMap &data)
 
 void KDarkLightScheduleSubscription::OnRefreshed(const QVariantMap &data)
 {
-    if (m_cookie) {
-        update(data[QStringLiteral("Schedule")]);
+    KNIGHTTIME_TRACE_SCOPE("subscription", "Refreshed");
+
+    if (!m_cookie) {
+        return;
+    }
+
+    if (auto it = data.find(QStringLiteral("Schedule")); it != data.end()) {
+        update(*it);
+    } else if (m_scheduleFile) {
+        if (!updateFromFile()) {
+            fallBackToDBus();
+        }
     }
 }
 
+void KDarkLightScheduleSubscription::OnRefreshedCycles(const QList<KNightTimeDbusCycle> &cycles)
+{
+    KNIGHTTIME_TRACE_SCOPE("subscription", "RefreshedCycles");
+
+    if (!m_cookie) {
+        return;
+    }
+
+    setSchedule(KNightTimeDbusCycle::intoSchedule(cycles));
+}
+
 void KDarkLightScheduleSubscription::OnDaemonRegistered()
 {
     // Usually, if we start the daemon, we will get the reply for the Subscribe request first, then
@@ -91,42 +178,127 @@ void KDarkLightScheduleSubscription::OnDaemonRegistered()
     // this code also handles when things are vice versa.
     //
     // If there is an in-flight subscribe request (but it fails) and the daemon dies and it is started
-    // again, this code assumes that the error reply will be processed before this slot gets called.
+    // again, this code assumes that the error reply will be processed before this slot gets called,
+    // and the retry has been scheduled already.
 
-    if (!m_cookie && !m_cookieWatcher) {
-        subscribe();
+    KNIGHTTIME_TRACE_INSTANT("subscription", "daemonRegistered");
+    if (!m_cookie && !m_cookieWatcher && !m_resubscribeTimer->isActive()) {
+        m_retryCount = 0;
+        scheduleSubscribe(s_resubscribeJitter);
     }
 }
 
 void KDarkLightScheduleSubscription::OnDaemonUnregistered()
 {
+    KNIGHTTIME_TRACE_INSTANT("subscription", "daemonUnregistered");
     m_cookie.reset();
+    m_renewTimer->stop();
+
+    // The next instance can be a different version of the daemon, e.g. after an upgrade.
+    m_version.reset();
 
     // Avoid resetting the cookie watcher. The subscribe request could have been sent around the
     // same time the daemon has been unregistered. In which case, the daemon will be started again.
 }
 
+void KDarkLightScheduleSubscription::restore()
+{
+    KNIGHTTIME_TRACE_SCOPE("subscription", "restore");
+
+    // Start with the schedule published by the running daemon, or the last one it has saved, so the
+    // correct schedule is available before the Subscribe() reply arrives.
+    if (auto scheduleFile = KDarkLightScheduleFile::open(KDarkLightScheduleFile::defaultFileName())) {
+        if (auto snapshot = scheduleFile->read()) {
+            m_scheduleFile = std::move(scheduleFile);
+            m_scheduleGeneration = snapshot->first;
+            m_schedule = std::move(snapshot->second);
+            m_restored = true;
+            return;
+        }
+    }
+
+    if (const auto scheduleFile = KDarkLightScheduleFile::open(KDarkLightScheduleFile::cacheFileName())) {
+        if (auto snapshot = scheduleFile->read()) {
+            m_schedule = std::move(snapshot->second);
+            m_restored = true;
+        }
+    }
+}
+
+void KDarkLightScheduleSubscription::queryVersion()
+{
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.freedesktop.DBus.Properties"), QStringLiteral("Get"));
+    message.setArguments({QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Version")});
+
+    m_cookieWatcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    connect(m_cookieWatcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+        if (m_cookieWatcher != watcher) {
+            return;
+        }
+        m_cookieWatcher = nullptr;
+
+        const QDBusPendingReply<QDBusVariant> reply = *watcher;
+        if (reply.isError()) {
+            qCWarning(KNIGHTTIME) << "Failed to query the API version:" << reply.error();
+            retrySubscribe();
+            return;
+        }
+
+        m_version = reply.value().variant().toUInt();
+        subscribe();
+    });
+}
+
 void KDarkLightScheduleSubscription::subscribe()
 {
+    // The daemon ignores the options it does not know, but the library must not rely on the
+    // features they enable, so every option is requested only from the version that has it.
+    if (!m_version) {
+        queryVersion();
+        return;
+    }
+
+    // The restored schedule is good enough to wait for a moment until the location is known.
+    QVariantMap options{
+        {QStringLiteral("SharedSchedule"), !m_sharedScheduleFailed},
+    };
+    if (*m_version >= s_typedRefreshedVersion) {
+        options.insert(QStringLiteral("TypedRefreshed"), true);
+    }
+    if (*m_version >= s_waitForAccurateVersion) {
+        options.insert(QStringLiteral("WaitForAccurate"), 5000u);
+    }
+    if (*m_version >= s_leaseVersion) {
+        options.insert(QStringLiteral("Lease"), true);
+    }
+
     auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Subscribe"));
-    message.setArguments({QVariantMap()});
+    message.setArguments({options});
+
+    const qint64 subscribeTimestamp = KNightTimeTracer::isEnabled() ? KNightTimeTracer::timestamp() : 0;
     auto pendingCall = QDBusConnection::sessionBus().asyncCall(message);
 
     m_cookieWatcher = new QDBusPendingCallWatcher(pendingCall);
-    connect(m_cookieWatcher, &QDBusPendingCallWatcher::finished, qApp, [self = QPointer(this)](QDBusPendingCallWatcher *watcher) {
+    connect(m_cookieWatcher, &QDBusPendingCallWatcher::finished, qApp, [self = QPointer(this), subscribeTimestamp](QDBusPendingCallWatcher *watcher) {
         watcher->deleteLater();
+        if (subscribeTimestamp) {
+            KNightTimeTracer::self()->complete("subscription", "Subscribe", subscribeTimestamp);
+        }
 
         if (watcher->isError()) {
+            qCWarning(KNIGHTTIME) << "Subscribe() failed:" << watcher->error();
             if (self && self->m_cookieWatcher == watcher) {
                 self->m_cookieWatcher = nullptr;
+                self->retrySubscribe();
             }
-            qCWarning(KNIGHTTIME) << "Subscribe() failed:" << watcher->error();
             return;
         }
 
         QDBusPendingReply<QVariantMap> reply = *watcher;
         if (self && self->m_cookieWatcher == watcher) {
             self->m_cookieWatcher = nullptr;
+            self->m_retryCount = 0;
 
             self->OnSubscribed(reply.value());
         } else {
@@ -137,12 +309,113 @@ void KDarkLightScheduleSubscription::subscribe()
     });
 }
 
+void KDarkLightScheduleSubscription::renew()
+{
+    if (!m_cookie) {
+        return;
+    }
+
+    auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Renew"));
+    message.setArguments({m_cookie.value()});
+
+    auto watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, cookie = m_cookie.value()](QDBusPendingCallWatcher *watcher) {
+        watcher->deleteLater();
+
+        // If the call fails, the daemon has most likely gone away, which is handled separately.
+        const QDBusPendingReply<bool> reply = *watcher;
+        if (reply.isError() || reply.value() || m_cookie != cookie) {
+            return;
+        }
+
+        // The lease has expired, e.g. because the process has been stopped for a while.
+        qCDebug(KNIGHTTIME) << "The subscription lease has expired, subscribing again";
+        m_cookie.reset();
+        m_renewTimer->stop();
+        if (!m_cookieWatcher) {
+            subscribe();
+        }
+    });
+}
+
+void KDarkLightScheduleSubscription::scheduleSubscribe(std::chrono::milliseconds maxDelay)
+{
+    // The delay is picked uniformly from the whole range, which spreads the clients best.
+    const auto delay = std::chrono::milliseconds(QRandomGenerator::global()->bounded(qint64(maxDelay.count()) + 1));
+    m_resubscribeTimer->start(delay);
+}
+
+void KDarkLightScheduleSubscription::retrySubscribe()
+{
+    // If the daemon cannot be started at all, wait until it shows up on the bus.
+    if (m_retryCount >= s_maxRetryCount) {
+        qCWarning(KNIGHTTIME) << "Giving up on subscribing to the schedule after" << m_retryCount << "attempts";
+        return;
+    }
+
+    const auto maxDelay = std::min(s_retryBaseDelay * (1 << m_retryCount), s_retryMaxDelay);
+    ++m_retryCount;
+    scheduleSubscribe(maxDelay);
+}
+
 void KDarkLightScheduleSubscription::update(const QVariant &data)
 {
+    KNIGHTTIME_TRACE_SCOPE("subscription", "update");
+
     const auto dbusSchedule = qdbus_cast<KNightTimeDbusSchedule>(data.value<QDBusArgument>());
-    m_schedule = dbusSchedule.into();
-    m_state = m_schedule->toState();
+    setSchedule(dbusSchedule.into());
+}
+
+void KDarkLightScheduleSubscription::setSchedule(const KDarkLightSchedule &schedule)
+{
+    m_schedule = schedule;
+    m_state.reset();
+    m_restored = false;
     Q_EMIT refreshed();
 }
 
+bool KDarkLightScheduleSubscription::updateFromFile()
+{
+    KNIGHTTIME_TRACE_SCOPE("subscription", "updateFromFile");
+
+    const auto snapshot = m_scheduleFile->read();
+    if (!snapshot) {
+        return false;
+    }
+
+    const auto &[generation, schedule] = *snapshot;
+    if (m_schedule && m_scheduleGeneration == generation) {
+        // The daemon has confirmed the restored schedule, the providers that have set it aside can use it now.
+        if (std::exchange(m_restored, false)) {
+            Q_EMIT refreshed();
+        }
+        return true;
+    }
+
+    m_scheduleGeneration = generation;
+    m_schedule = schedule;
+    m_state.reset();
+    m_restored = false;
+    Q_EMIT refreshed();
+    return true;
+}
+
+void KDarkLightScheduleSubscription::fallBackToDBus()
+{
+    qCWarning(KNIGHTTIME) << "Failed to read the shared schedule, falling back to receiving the schedule over D-Bus";
+
+    m_scheduleFile.reset();
+    m_sharedScheduleFailed = true;
+
+    if (m_cookie) {
+        auto message = QDBusMessage::createMethodCall(QStringLiteral("org.kde.NightTime"), QStringLiteral("/org/kde/NightTime/Manager"), QStringLiteral("org.kde.NightTime.Manager"), QStringLiteral("Unsubscribe"));
+        message.setArguments({m_cookie.value()});
+        QDBusConnection::sessionBus().asyncCall(message);
+        m_cookie.reset();
+        m_renewTimer->stop();
+    }
+
+    subscribe();
+}
+
 #include "moc_kdarklightschedulesubscription_p.cpp"
@@ -6,13 +6,21 @@
 
 #pragma once
 
+#include "kdarklightdbustypes_p.h"
 #include "kdarklightschedule.h"
+#include "knighttime_export.h"
 
 #include <QDBusPendingCallWatcher>
 #include <QDBusServiceWatcher>
 #include <QObject>
+#include <QTimer>
 
-class KDarkLightScheduleSubscription : public QObject
+class KDarkLightScheduleFile;
+
+/*
+ * This is private API, it is exported only for tests.
+ */
+class KNIGHTTIME_EXPORT KDarkLightScheduleSubscription : public QObject
 {
     Q_OBJECT
 
@@ -23,6 +31,12 @@ public:
     std::optional<KDarkLightSchedule> schedule() const;
     QString state() const;
 
+    /*
+     * Returns true if the schedule has been restored from a file and not been confirmed by the
+     * daemon yet, so it can be older than what the application has saved.
+     */
+    bool isRestored() const;
+
     static std::shared_ptr<KDarkLightScheduleSubscription> globalSubscription();
 
 Q_SIGNALS:
@@ -31,16 +45,33 @@ Q_SIGNALS:
 private Q_SLOTS:
     void OnSubscribed(const QVariantMap &data);
     void OnRefreshed(const QVariantMap &data);
+    void OnRefreshedCycles(const QList<KNightTimeDbusCycle> &cycles);
     void OnDaemonRegistered();
     void OnDaemonUnregistered();
 
 private:
+    void restore();
+    void queryVersion();
     void subscribe();
+    void scheduleSubscribe(std::chrono::milliseconds maxDelay);
+    void retrySubscribe();
+    void renew();
     void update(const QVariant &data);
+    void setSchedule(const KDarkLightSchedule &schedule);
+    bool updateFromFile();
+    void fallBackToDBus();
 
     std::unique_ptr<QDBusServiceWatcher> m_daemonWatcher;
     std::optional<KDarkLightSchedule> m_schedule;
-    QString m_state;
+    mutable std::optional<QString> m_state;
     QDBusPendingCallWatcher *m_cookieWatcher = nullptr;
+    std::unique_ptr<QTimer> m_resubscribeTimer;
+    std::unique_ptr<QTimer> m_renewTimer;
+    int m_retryCount = 0;
     std::optional<uint> m_cookie;
+    std::optional<uint> m_version;
+    std::unique_ptr<KDarkLightScheduleFile> m_scheduleFile;
+    quint64 m_scheduleGeneration = 0;
+    bool m_sharedScheduleFailed = false;
+    bool m_restored = false;
 };
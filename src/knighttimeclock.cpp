@@ -0,0 +1,194 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knighttimeclock_p.h"
+#include "knighttimelogging.h"
+
+#include <KSystemClockSkewNotifier>
+
+#include <QMetaMethod>
+#include <QTimer>
+
+class KNightTimeSystemTimer : public KNightTimeTimer
+{
+public:
+    KNightTimeSystemTimer()
+    {
+        // Coarse timers may fire up to 5% early or late, that is minutes for the intervals used here.
+        m_timer.setTimerType(Qt::PreciseTimer);
+        m_timer.setSingleShot(true);
+        connect(&m_timer, &QTimer::timeout, this, &KNightTimeTimer::timeout);
+    }
+
+    void start(std::chrono::milliseconds interval) override
+    {
+        m_timer.start(interval);
+    }
+
+    void stop() override
+    {
+        m_timer.stop();
+    }
+
+    bool isActive() const override
+    {
+        return m_timer.isActive();
+    }
+
+    std::chrono::milliseconds interval() const override
+    {
+        return m_timer.intervalAsDuration();
+    }
+
+private:
+    QTimer m_timer;
+};
+
+class KNightTimeSystemClock : public KNightTimeClock
+{
+public:
+    QDateTime currentDateTime() const override
+    {
+        return QDateTime::currentDateTime();
+    }
+
+    std::unique_ptr<KNightTimeTimer> createTimer() override
+    {
+        return std::make_unique<KNightTimeSystemTimer>();
+    }
+
+protected:
+    void connectNotify(const QMetaMethod &signal) override
+    {
+        // Watching for clock skews requires a timerfd, so only do it if somebody is interested.
+        if (signal == QMetaMethod::fromSignal(&KNightTimeClock::skewed) && !m_skewNotifier) {
+            m_skewNotifier = std::make_unique<KSystemClockSkewNotifier>();
+            m_skewNotifier->setActive(true);
+            connect(m_skewNotifier.get(), &KSystemClockSkewNotifier::skewed, this, &KNightTimeClock::skewed);
+        }
+    }
+
+private:
+    std::unique_ptr<KSystemClockSkewNotifier> m_skewNotifier;
+};
+
+KNightTimeClock *KNightTimeClock::system()
+{
+    // Intentionally leaked so the clock skew notifier is not destroyed after the application.
+    static KNightTimeSystemClock *clock = new KNightTimeSystemClock();
+    return clock;
+}
+
+class KNightTimeVirtualTimer : public KNightTimeTimer
+{
+public:
+    explicit KNightTimeVirtualTimer(KNightTimeVirtualClock *clock)
+        : m_clock(clock)
+    {
+        m_clock->m_timers.append(this);
+    }
+
+    ~KNightTimeVirtualTimer() override
+    {
+        if (m_clock) {
+            m_clock->m_timers.removeOne(this);
+        }
+    }
+
+    void start(std::chrono::milliseconds interval) override
+    {
+        m_interval = interval;
+        m_deadline = m_clock->m_elapsed + interval;
+        m_active = true;
+    }
+
+    void stop() override
+    {
+        m_active = false;
+    }
+
+    bool isActive() const override
+    {
+        return m_active;
+    }
+
+    std::chrono::milliseconds interval() const override
+    {
+        return m_interval;
+    }
+
+    KNightTimeVirtualClock *m_clock;
+    std::chrono::milliseconds m_interval{0};
+    std::chrono::milliseconds m_deadline{0};
+    bool m_active = false;
+};
+
+KNightTimeVirtualClock::KNightTimeVirtualClock(const QDateTime &dateTime)
+    : m_dateTime(dateTime)
+{
+}
+
+KNightTimeVirtualClock::~KNightTimeVirtualClock()
+{
+    for (KNightTimeVirtualTimer *timer : std::as_const(m_timers)) {
+        timer->m_clock = nullptr;
+    }
+}
+
+QDateTime KNightTimeVirtualClock::currentDateTime() const
+{
+    return m_dateTime;
+}
+
+std::unique_ptr<KNightTimeTimer> KNightTimeVirtualClock::createTimer()
+{
+    return std::make_unique<KNightTimeVirtualTimer>(this);
+}
+
+void KNightTimeVirtualClock::advance(std::chrono::milliseconds duration)
+{
+    // A timer that keeps restarting itself with a zero interval would never let the time move on.
+    constexpr int maxTimeoutsPerInstant = 10000;
+
+    const std::chrono::milliseconds target = m_elapsed + duration;
+    int instantTimeouts = 0;
+
+    while (true) {
+        KNightTimeVirtualTimer *nextTimer = nullptr;
+        for (KNightTimeVirtualTimer *timer : std::as_const(m_timers)) {
+            if (timer->m_active && timer->m_deadline <= target && (!nextTimer || timer->m_deadline < nextTimer->m_deadline)) {
+                nextTimer = timer;
+            }
+        }
+        if (!nextTimer) {
+            break;
+        }
+
+        if (nextTimer->m_deadline != m_elapsed) {
+            instantTimeouts = 0;
+        } else if (++instantTimeouts > maxTimeoutsPerInstant) {
+            qCWarning(KNIGHTTIME) << "Timers keep firing at the same instant, skipping the rest until the next advance";
+            break;
+        }
+
+        m_dateTime = m_dateTime.addMSecs((nextTimer->m_deadline - m_elapsed).count());
+        m_elapsed = nextTimer->m_deadline;
+
+        nextTimer->m_active = false;
+        Q_EMIT nextTimer->timeout();
+    }
+
+    m_dateTime = m_dateTime.addMSecs((target - m_elapsed).count());
+    m_elapsed = target;
+}
+
+void KNightTimeVirtualClock::skew(std::chrono::milliseconds offset)
+{
+    m_dateTime = m_dateTime.addMSecs(offset.count());
+    Q_EMIT skewed();
+}
+
+#include "moc_knighttimeclock_p.cpp"
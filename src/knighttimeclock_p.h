@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "knighttime_export.h"
+
+#include <QDateTime>
+#include <QObject>
+
+#include <chrono>
+#include <memory>
+
+/*
+ * The KNightTimeTimer is a single-shot timer driven by a KNightTimeClock. Like QTimer, it measures
+ * elapsed time, so it is not affected by clock skews.
+ *
+ * This is private API, it is exported only for knighttimed and tests.
+ */
+class KNIGHTTIME_EXPORT KNightTimeTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    virtual void start(std::chrono::milliseconds interval) = 0;
+    virtual void stop() = 0;
+    virtual bool isActive() const = 0;
+    virtual std::chrono::milliseconds interval() const = 0;
+
+Q_SIGNALS:
+    void timeout();
+};
+
+/*
+ * The KNightTimeClock provides the current date and time, timers, and notifications about clock
+ * skews. The system clock is used normally, a virtual clock can be injected to simulate long
+ * periods of time.
+ *
+ * This is private API, it is exported only for knighttimed and tests.
+ */
+class KNIGHTTIME_EXPORT KNightTimeClock : public QObject
+{
+    Q_OBJECT
+
+public:
+    static KNightTimeClock *system();
+
+    virtual QDateTime currentDateTime() const = 0;
+    virtual std::unique_ptr<KNightTimeTimer> createTimer() = 0;
+
+Q_SIGNALS:
+    /*
+     * This signal is emitted when the system clock jumps, for example because the time has been
+     * changed manually.
+     */
+    void skewed();
+};
+
+class KNightTimeVirtualTimer;
+
+/*
+ * The KNightTimeVirtualClock is a clock that only moves when it is told so.
+ */
+class KNIGHTTIME_EXPORT KNightTimeVirtualClock : public KNightTimeClock
+{
+    Q_OBJECT
+
+public:
+    explicit KNightTimeVirtualClock(const QDateTime &dateTime);
+    ~KNightTimeVirtualClock() override;
+
+    QDateTime currentDateTime() const override;
+    std::unique_ptr<KNightTimeTimer> createTimer() override;
+
+    /*
+     * Moves the clock forward by the specified \a duration. The timers that expire on the way are
+     * fired in order, at their deadlines. If timers keep restarting with a zero interval, the ones
+     * left after a few thousand timeouts at the same instant are fired by the next advance().
+     */
+    void advance(std::chrono::milliseconds duration);
+
+    /*
+     * Makes the clock jump by the specified \a offset without firing any timers, and emits skewed().
+     */
+    void skew(std::chrono::milliseconds offset);
+
+private:
+    friend class KNightTimeVirtualTimer;
+
+    QDateTime m_dateTime;
+    std::chrono::milliseconds m_elapsed{0};
+    QList<KNightTimeVirtualTimer *> m_timers;
+};
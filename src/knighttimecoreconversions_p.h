@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "kdarklightschedule.h"
+#include "knighttimecore.h"
+
+/*
+ * Conversions between the Qt types and their KNightTimeCore counterparts.
+ *
+ * This is private API, it is used only by the library and tests.
+ */
+namespace KNightTimeCore
+{
+
+inline TimePoint toCoreTime(const QDateTime &dateTime)
+{
+    return TimePoint(std::chrono::milliseconds(dateTime.toMSecsSinceEpoch()));
+}
+
+inline QDateTime fromCoreTime(TimePoint time)
+{
+    return QDateTime::fromMSecsSinceEpoch(time.time_since_epoch().count());
+}
+
+inline Transition toCoreTransition(const KDarkLightTransition &transition)
+{
+    return Transition{
+        .type = Transition::Type(transition.type()),
+        .start = toCoreTime(transition.startDateTime()),
+        .end = toCoreTime(transition.endDateTime()),
+    };
+}
+
+inline KDarkLightTransition fromCoreTransition(const Transition &transition)
+{
+    return KDarkLightTransition(KDarkLightTransition::Type(transition.type), fromCoreTime(transition.start), fromCoreTime(transition.end));
+}
+
+inline std::optional<KDarkLightTransition> fromCoreTransition(const std::optional<Transition> &transition)
+{
+    if (!transition) {
+        return std::nullopt;
+    }
+    return fromCoreTransition(*transition);
+}
+
+inline Cycle toCoreCycle(const KDarkLightCycle &cycle)
+{
+    return Cycle{
+        .noon = toCoreTime(cycle.noonDateTime()),
+        .morning = toCoreTransition(cycle.morning()),
+        .evening = toCoreTransition(cycle.evening()),
+    };
+}
+
+inline KDarkLightCycle fromCoreCycle(const Cycle &cycle)
+{
+    return KDarkLightCycle(fromCoreTime(cycle.noon), fromCoreTransition(cycle.morning), fromCoreTransition(cycle.evening));
+}
+
+inline Schedule toCoreSchedule(const QList<KDarkLightCycle> &cycles)
+{
+    Schedule schedule;
+    schedule.cycles.reserve(cycles.size());
+    for (const KDarkLightCycle &cycle : cycles) {
+        schedule.cycles.push_back(toCoreCycle(cycle));
+    }
+    return schedule;
+}
+
+inline Schedule toCoreSchedule(const KDarkLightSchedule &schedule)
+{
+    return toCoreSchedule(schedule.cycles());
+}
+
+inline KDarkLightSchedule fromCoreSchedule(const Schedule &schedule)
+{
+    QList<KDarkLightCycle> cycles;
+    cycles.reserve(schedule.cycles.size());
+    for (const Cycle &cycle : schedule.cycles) {
+        cycles.append(fromCoreCycle(cycle));
+    }
+    return KDarkLightSchedule(cycles);
+}
+
+} // namespace KNightTimeCore
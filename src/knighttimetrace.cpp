@@ -0,0 +1,162 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "knighttimetrace_p.h"
+#include "knighttimetracelogging.h"
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include <chrono>
+
+// Bounds the memory used by a long trace.
+static const qsizetype s_maxBufferSize = 4 * 1024 * 1024;
+
+std::atomic<bool> KNightTimeTracer::s_enabled = qEnvironmentVariableIsSet("KNIGHTTIME_TRACE_FILE");
+
+KNightTimeTracer *KNightTimeTracer::self()
+{
+    static KNightTimeTracer tracer;
+    return &tracer;
+}
+
+KNightTimeTracer::KNightTimeTracer()
+{
+    const QString fileName = qEnvironmentVariable("KNIGHTTIME_TRACE_FILE");
+    if (fileName.isEmpty() || !start(fileName)) {
+        s_enabled = false;
+    }
+}
+
+KNightTimeTracer::~KNightTimeTracer()
+{
+    stop();
+}
+
+bool KNightTimeTracer::start(const QString &fileName)
+{
+    stop();
+
+    QString effectiveFileName = fileName;
+    effectiveFileName.replace(QLatin1String("%p"), QString::number(QCoreApplication::applicationPid()));
+
+    auto file = std::make_unique<QFile>(effectiveFileName);
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(KNIGHTTIME_TRACE) << "Failed to open the trace file" << effectiveFileName << ":" << file->errorString();
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_file = std::move(file);
+        m_buffer = QByteArrayLiteral("[\n");
+        m_empty = true;
+        s_enabled = true;
+    }
+
+    const QJsonObject metadata{
+        {QStringLiteral("name"), QStringLiteral("process_name")},
+        {QStringLiteral("ph"), QStringLiteral("M")},
+        {QStringLiteral("pid"), QCoreApplication::applicationPid()},
+        {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), QCoreApplication::applicationName()}}},
+    };
+    write(QJsonDocument(metadata).toJson(QJsonDocument::Compact));
+
+    return true;
+}
+
+void KNightTimeTracer::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    s_enabled = false;
+    if (m_file) {
+        m_buffer.append("\n]\n");
+        flushLocked();
+        m_file.reset();
+    }
+}
+
+void KNightTimeTracer::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file) {
+        flushLocked();
+    }
+}
+
+void KNightTimeTracer::flushLocked()
+{
+    m_file->write(m_buffer);
+    m_file->flush();
+    m_buffer.clear();
+}
+
+qint64 KNightTimeTracer::timestamp()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void KNightTimeTracer::complete(const char *category, const char *name, qint64 startTimestamp, const QString &detail)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    QJsonObject event{
+        {QStringLiteral("name"), QLatin1String(name)},
+        {QStringLiteral("cat"), QLatin1String(category)},
+        {QStringLiteral("ph"), QStringLiteral("X")},
+        {QStringLiteral("ts"), startTimestamp},
+        {QStringLiteral("dur"), timestamp() - startTimestamp},
+        {QStringLiteral("pid"), QCoreApplication::applicationPid()},
+        {QStringLiteral("tid"), qint64(quintptr(QThread::currentThreadId()))},
+    };
+    if (!detail.isEmpty()) {
+        event[QStringLiteral("args")] = QJsonObject{{QStringLiteral("detail"), detail}};
+    }
+    write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+}
+
+void KNightTimeTracer::instant(const char *category, const char *name, const QString &detail)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    QJsonObject event{
+        {QStringLiteral("name"), QLatin1String(name)},
+        {QStringLiteral("cat"), QLatin1String(category)},
+        {QStringLiteral("ph"), QStringLiteral("i")},
+        {QStringLiteral("s"), QStringLiteral("p")},
+        {QStringLiteral("ts"), timestamp()},
+        {QStringLiteral("pid"), QCoreApplication::applicationPid()},
+        {QStringLiteral("tid"), qint64(quintptr(QThread::currentThreadId()))},
+    };
+    if (!detail.isEmpty()) {
+        event[QStringLiteral("args")] = QJsonObject{{QStringLiteral("detail"), detail}};
+    }
+    write(QJsonDocument(event).toJson(QJsonDocument::Compact));
+}
+
+void KNightTimeTracer::write(const QByteArray &event)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file) {
+        return;
+    }
+
+    if (!m_empty) {
+        m_buffer.append(",\n");
+    }
+    m_buffer.append(event);
+    m_empty = false;
+
+    if (m_buffer.size() >= s_maxBufferSize) {
+        flushLocked();
+    }
+}
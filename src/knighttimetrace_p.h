@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2025 Vlad Zahorodnii <vlad.zahorodnii@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "knighttime_export.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+/*
+ * The KNightTimeTracer writes trace events in the Chrome trace event format. The resulting file
+ * can be loaded in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Tracing is disabled by default. It can be enabled by setting the KNIGHTTIME_TRACE_FILE environment
+ * variable to the path of the output file, "%p" in the path is replaced with the process id. The
+ * tracer can also be started and stopped at runtime. Timestamps are taken from the monotonic clock,
+ * so traces of the daemon and its clients can be merged together.
+ *
+ * The events are buffered in memory and written out when the tracer is stopped, at exit, or when
+ * the buffer grows large, so writing the trace does not show up in it.
+ *
+ * Use the KNIGHTTIME_TRACE_SCOPE and KNIGHTTIME_TRACE_INSTANT macros, they cost one relaxed atomic
+ * load and do not evaluate the details when tracing is disabled.
+ *
+ * This is private API, it is exported only for knighttimed and tests.
+ */
+class KNIGHTTIME_EXPORT KNightTimeTracer
+{
+public:
+    static KNightTimeTracer *self();
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    bool start(const QString &fileName);
+    void stop();
+
+    /*
+     * Writes the buffered events to the trace file.
+     */
+    void flush();
+
+    void complete(const char *category, const char *name, qint64 startTimestamp, const QString &detail = QString());
+    void instant(const char *category, const char *name, const QString &detail = QString());
+
+    static qint64 timestamp();
+
+private:
+    KNightTimeTracer();
+    ~KNightTimeTracer();
+
+    void write(const QByteArray &event);
+    void flushLocked();
+
+    // The tracer is created lazily at the first trace point if the environment asks for it.
+    static std::atomic<bool> s_enabled;
+
+    QMutex m_mutex;
+    std::unique_ptr<QFile> m_file;
+    QByteArray m_buffer;
+    bool m_empty = true;
+};
+
+/*
+ * The KNightTimeTraceScope records the time spent in the current scope as a complete event.
+ */
+class KNightTimeTraceScope
+{
+public:
+    KNightTimeTraceScope(const char *category, const char *name, const QString &detail = QString())
+        : m_category(category)
+        , m_name(name)
+        , m_detail(detail)
+        , m_startTimestamp(KNightTimeTracer::isEnabled() ? KNightTimeTracer::timestamp() : -1)
+    {
+    }
+
+    ~KNightTimeTraceScope()
+    {
+        if (m_startTimestamp != -1) {
+            KNightTimeTracer::self()->complete(m_category, m_name, m_startTimestamp, m_detail);
+        }
+    }
+
+private:
+    const char *m_category;
+    const char *m_name;
+    QString m_detail;
+    qint64 m_startTimestamp;
+};
+
+#define KNIGHTTIME_TRACE_CONCAT_IMPL(a, b) a##b
+#define KNIGHTTIME_TRACE_CONCAT(a, b) KNIGHTTIME_TRACE_CONCAT_IMPL(a, b)
+
+#define KNIGHTTIME_TRACE_SCOPE(category, name, ...)                                     \
+    const KNightTimeTraceScope KNIGHTTIME_TRACE_CONCAT(knighttimeTraceScope, __LINE__)( \
+        category,                                                                       \
+        name __VA_OPT__(, KNightTimeTracer::isEnabled() ? QString(__VA_ARGS__) : QString()))
+
+#define KNIGHTTIME_TRACE_INSTANT(category, name, ...)                                 \
+    do {                                                                              \
+        if (KNightTimeTracer::isEnabled()) {                                          \
+            KNightTimeTracer::self()->instant(category, name __VA_OPT__(, __VA_ARGS__)); \
+        }                                                                             \
+    } while (false)